@@ -1,5 +1,6 @@
 import Gio from 'gi://Gio';
 import GLib from 'gi://GLib';
+import { Transcript } from '../utils/Transcript.js';
 
 /**
  * Performance-optimized audio recorder with streaming capabilities
@@ -8,18 +9,32 @@ export class AudioRecorder {
     constructor(extensionPath) {
         this.extensionPath = extensionPath;
         this.isRecording = false;
+        this.isStopping = false;
         this.process = null;
+        this.stopTimer = null;
         this.textMonitor = null;
         this.audioLevelMonitor = null;
-        this.lastTextContent = '';
+        this.lastTranslatedContent = '';
         this.lastAudioLevel = 0;
         
+        // Recognized text, kept up to date from the backend's edit stream
+        this.updatesOffset = 0;
+        this.transcript = new Transcript();
+        
         // File paths for faster access
         this.textFilePath = `${extensionPath}/ses/recognized_text.txt`;
+        this.updatesFilePath = `${extensionPath}/ses/text_updates.txt`;
+        this.translatedFilePath = `${extensionPath}/ses/translated_text.txt`;
         this.levelFilePath = `${extensionPath}/ses/audio_level.txt`;
+        this.controlSocketPath = `${extensionPath}/ses/control.sock`;
+        
+        // Backend settings passed as --set key=value on start
+        this.backendOptions = {};
         
         this.callbacks = {
             onText: null,
+            onSegment: null,
+            onTranslation: null,
             onStatus: null,
             onAudioLevel: null
         };
@@ -48,10 +63,52 @@ export class AudioRecorder {
         }
     }
 
+    /**
+     * Set a backend option (same keys as ses/recorder_settings.txt).
+     * Applied on the next start; use updateBackendOption() while recording.
+     */
+    setBackendOption(key, value) {
+        this.backendOptions[key] = String(value);
+    }
+
+    /**
+     * Change a backend option on the running process via the control socket
+     */
+    updateBackendOption(key, value) {
+        this.setBackendOption(key, value);
+        if (this.isRecording) {
+            this.sendControl(`set ${key} ${value}`);
+        }
+    }
+
+    /**
+     * Send one command line to the backend control socket (fire and forget)
+     */
+    sendControl(line) {
+        try {
+            const client = new Gio.SocketClient();
+            const address = Gio.UnixSocketAddress.new(this.controlSocketPath);
+            client.connect_async(address, null, (source, result) => {
+                try {
+                    const connection = source.connect_finish(result);
+                    const payload = new TextEncoder().encode(`${line}\n`);
+                    connection.get_output_stream().write_all(payload, null);
+                    connection.close(null);
+                } catch (error) {
+                    console.log(`Control command failed: ${error.message}`);
+                }
+            });
+        } catch (error) {
+            console.log(`Control command failed: ${error.message}`);
+        }
+    }
+
     /**
      * Start recording with optimized monitoring
      * @param {number} mode - 1: Microphone, 2: System audio
-     * @param {Object} callbacks - {onText, onStatus, onAudioLevel}
+     * @param {Object} callbacks - {onText, onSegment, onTranslation, onStatus, onAudioLevel};
+     *   onText(transcript, {changes, final}) gets the edits applied since
+     *   the last call, as changes to the displayed text (see Transcript)
      */
     startRecording(mode, callbacks = {}) {
         if (this.isRecording) {
@@ -72,20 +129,44 @@ export class AudioRecorder {
     }
 
     /**
-     * Stop recording and cleanup
+     * Ask the backend to stop. It decodes what is still queued, writes the
+     * last words and exits within its stop-deadline-ms, so the output files
+     * are read until the process is gone; it is killed if it overstays.
      */
     stopRecording() {
         if (!this.isRecording || !this.process) return;
 
+        this.isRecording = false;
+        this.isStopping = true;
+        const pid = this.process.pid;
         try {
-            GLib.spawn_command_line_sync(`kill -2 ${this.process.pid}`);
+            GLib.spawn_command_line_sync(`kill -INT ${pid}`);
             this._notifyStatus('Kayıt durduruluyor...', 'stopping');
         } catch (error) {
             console.log(`Recording stop error: ${error.message}`);
         }
         
+        const deadline = Number(this.backendOptions['stop-deadline-ms'] ?? 3000);
+        if (deadline > 0) {
+            this.stopTimer = GLib.timeout_add(GLib.PRIORITY_DEFAULT, deadline + 2000, () => {
+                this.stopTimer = null;
+                console.log('Backend did not stop in time, killing it');
+                GLib.spawn_command_line_sync(`kill -KILL ${pid}`);
+                return GLib.SOURCE_REMOVE;
+            });
+        }
+        
         this._logPerformanceStats();
-        this._cleanup();
+    }
+
+    /**
+     * Stop delivering callbacks (the owner is going away); a stopping
+     * backend still finishes writing its files
+     */
+    detach() {
+        for (const key of Object.keys(this.callbacks)) {
+            this.callbacks[key] = null;
+        }
     }
 
     /**
@@ -94,7 +175,7 @@ export class AudioRecorder {
     _startOptimizedMonitoring() {
         // Ultra-fast monitoring for real-time performance (50ms for better stability)
         this.textMonitor = GLib.timeout_add(GLib.PRIORITY_HIGH, 50, () => {
-            if (!this.isRecording) return GLib.SOURCE_REMOVE;
+            if (!this.process) return GLib.SOURCE_REMOVE;
             
             // Check both files in parallel
             this._checkFiles();
@@ -108,22 +189,35 @@ export class AudioRecorder {
     _checkFiles() {
         // Use GLib.spawn_async for faster file reading
         try {
-            // Read text file
-            let [textSuccess, textContents] = GLib.file_get_contents(this.textFilePath);
-            if (textSuccess) {
-                const currentText = new TextDecoder().decode(textContents).trim();
-                if (currentText !== this.lastTextContent) {
-                    this.lastTextContent = currentText;
-                    this.performanceStats.textUpdates++;
-                    
-                    if (this.callbacks.onText && currentText) {
-                        this.callbacks.onText(currentText);
+            // Apply new text edits, if any
+            const update = this._readTextUpdates();
+            if (update) {
+                this.performanceStats.textUpdates++;
+                
+                if (this.callbacks.onText) {
+                    this.callbacks.onText(this.transcript,
+                        { changes: update.changes, final: update.finalized.length > 0 });
+                }
+                
+                // One event per finished segment, with the backend's segment id
+                if (this.callbacks.onSegment) {
+                    for (const { id, text } of update.finalized) {
+                        this.callbacks.onSegment(id, text);
+                    }
+                }
+            }
+            
+            // Read translated text file (only written by backend translation)
+            if (this.callbacks.onTranslation) {
+                let [translatedSuccess, translatedContents] = GLib.file_get_contents(this.translatedFilePath);
+                if (translatedSuccess) {
+                    const translatedText = new TextDecoder().decode(translatedContents).trim();
+                    if (translatedText !== this.lastTranslatedContent) {
+                        this.lastTranslatedContent = translatedText;
+                        if (translatedText) {
+                            this.callbacks.onTranslation(translatedText);
+                        }
                     }
-                    
-                    this._notifyStatus(
-                        currentText ? `🔊 "${currentText}"` : '🎤 Dinliyor...', 
-                        'text_update'
-                    );
                 }
             }
             
@@ -148,9 +242,66 @@ export class AudioRecorder {
         }
     }
 
+    /**
+     * Reads only the lines appended to text_updates.txt since the last call
+     * and applies them. Each line edits one segment (utterance):
+     * "<segment> <p|f> <keep> <stable> <tail>" keeps its first `keep`
+     * characters and appends `tail`; the first `stable` characters are
+     * committed and "f" marks the segment final. See ses/text_updates.h.
+     * @returns {{changes: Array, finalized: Array<{id: number, text: string}>}|null}
+     *   the changes to the displayed text and the segments that became
+     *   final; null when nothing changed
+     */
+    _readTextUpdates() {
+        const file = Gio.File.new_for_path(this.updatesFilePath);
+        const size = file.query_info('standard::size', Gio.FileQueryInfoFlags.NONE, null).get_size();
+        if (size < this.updatesOffset) {
+            // Truncated: the backend started a new session
+            this._resetTextUpdates();
+        }
+        if (size === this.updatesOffset) return null;
+        
+        const stream = file.read(null);
+        stream.seek(this.updatesOffset, GLib.SeekType.SET, null);
+        const bytes = stream.read_bytes(size - this.updatesOffset, null).toArray();
+        stream.close(null);
+        
+        // A line still being written is picked up on the next poll
+        const end = bytes.lastIndexOf(10);
+        if (end < 0) return null;
+        this.updatesOffset += end + 1;
+        
+        const changes = [];
+        const finalized = [];
+        for (const line of new TextDecoder().decode(bytes.subarray(0, end)).split('\n')) {
+            const match = /^(\d+) ([pf]) (\d+) (\d+) (.*)$/.exec(line);
+            if (!match) continue;
+            const [, id, kind, keep, stable, tail] = match;
+            const final = kind === 'f';
+            const change = this.transcript.apply(Number(id), Number(keep), tail, Number(stable), final);
+            changes.push(change);
+            if (final) finalized.push({ id: Number(id), text: change.text });
+        }
+        return { changes, finalized };
+    }
+
+    /**
+     * A new transcript object rather than a cleared one: the UI may still
+     * show (and copy from) the previous recording's
+     */
+    _resetTextUpdates() {
+        this.updatesOffset = 0;
+        this.transcript = new Transcript();
+    }
+
     _startCppProcess(mode) {
         const workingDirectory = `${this.extensionPath}/ses`;
-        const command = `echo "${mode}" | ${workingDirectory}/audio_recorder`;
+        const options = Object.entries(this.backendOptions)
+            .map(([key, value]) => ` --set ${GLib.shell_quote(`${key}=${value}`)}`)
+            .join('');
+        // exec, so the pid we signal on stop is the recorder's own rather
+        // than that of a shell waiting for it
+        const command = `exec ${workingDirectory}/audio_recorder${options} <<< "${mode}"`;
         
         try {
             let [success, pid] = GLib.spawn_async(
@@ -181,25 +332,53 @@ export class AudioRecorder {
         try {
             // Use faster file operations
             GLib.file_set_contents(this.textFilePath, '');
+            GLib.file_set_contents(this.updatesFilePath, '');
+            GLib.file_set_contents(this.translatedFilePath, '');
             GLib.file_set_contents(this.levelFilePath, '0');
         } catch (error) {
             // Files will be created by C++ process if they don't exist
         }
         
         // Reset cached values
-        this.lastTextContent = '';
+        this._resetTextUpdates();
+        this.lastTranslatedContent = '';
         this.lastAudioLevel = 0;
     }
 
     _onProcessFinished(status) {
+        // Whatever the backend wrote before exiting; segments it had no
+        // time to finalize are kept as last shown
+        this._checkFiles();
+        this._finalizeOpenSegments();
         this._cleanup();
         this._notifyStatus('Kayıt tamamlandı', 'finished');
     }
 
+    _finalizeOpenSegments() {
+        const finalized = this.transcript.finalizeOpen();
+        if (finalized.length === 0) return;
+        
+        // The text stays as shown; only its tentative tail is no longer dimmed
+        if (this.callbacks.onText) {
+            this.callbacks.onText(this.transcript, { changes: [], final: true });
+        }
+        if (this.callbacks.onSegment) {
+            for (const { id, text } of finalized) {
+                this.callbacks.onSegment(id, text);
+            }
+        }
+    }
+
     _cleanup() {
         this.isRecording = false;
+        this.isStopping = false;
         this.process = null;
         
+        if (this.stopTimer) {
+            GLib.Source.remove(this.stopTimer);
+            this.stopTimer = null;
+        }
+        
         if (this.textMonitor) {
             GLib.Source.remove(this.textMonitor);
             this.textMonitor = null;
@@ -211,7 +390,8 @@ export class AudioRecorder {
         }
         
         // Clear cached values
-        this.lastTextContent = '';
+        this._resetTextUpdates();
+        this.lastTranslatedContent = '';
         this.lastAudioLevel = 0;
     }
 
@@ -236,6 +416,15 @@ export class AudioRecorder {
         return this.isRecording;
     }
 
+    get stopping() {
+        return this.isStopping;
+    }
+
+    /** Full recognized text of the current recording */
+    get recognizedText() {
+        return this.transcript.text;
+    }
+
     get stats() {
         return this.performanceStats;
     }
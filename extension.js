@@ -10,6 +10,7 @@ import { Utils, Constants } from './utils/Utils.js';
 import { initTranslation, _ } from './utils/Translation.js';
 import { ModelManager } from './utils/ModelManager.js';
 import { TranslationManager } from './utils/TranslationManager.js';
+import { SegmentTranslator } from './utils/SegmentTranslator.js';
 
 export default class SpeechToTextExtension extends Extension {
     constructor(metadata) {
@@ -19,9 +20,12 @@ export default class SpeechToTextExtension extends Extension {
         this.audioRecorder = null;
         this.modelManager = null;
         this.translationManager = null;
+        this.segmentTranslator = null;
+        this.stoppingRecorder = null;
         this.settings = null;
         this.recordingMode = Constants.RECORDING_MODES.MICROPHONE;
         this.isRecording = false;
+        this.backendSettingsIds = [];
     }
 
     enable() {
@@ -54,6 +58,28 @@ export default class SpeechToTextExtension extends Extension {
         // Set initial recording mode
         this._setRecordingMode(Constants.RECORDING_MODES.MICROPHONE);
         
+        // Forward live changes of backend-side settings to a running recorder
+        this.backendSettingsIds = [
+            this.settings.connect('changed::noise-reduction', () => {
+                if (this.audioRecorder) {
+                    this.audioRecorder.updateBackendOption('noise-reduction',
+                        this.settings.get_boolean('noise-reduction'));
+                }
+            }),
+            this.settings.connect('changed::microphone-sensitivity', () => {
+                if (this.audioRecorder) {
+                    this.audioRecorder.updateBackendOption('microphone-sensitivity',
+                        this.settings.get_int('microphone-sensitivity'));
+                }
+            }),
+            this.settings.connect('changed::endpoint-profile', () => {
+                if (this.audioRecorder) {
+                    this.audioRecorder.updateBackendOption('endpoint-profile',
+                        this.settings.get_string('endpoint-profile'));
+                }
+            })
+        ];
+        
         // Auto-record if enabled
         if (this.settings.get_boolean('auto-record')) {
             GLib.timeout_add(GLib.PRIORITY_DEFAULT, 1000, () => {
@@ -66,6 +92,11 @@ export default class SpeechToTextExtension extends Extension {
     disable() {
         // Stop any active recording first
         this._stopRecording();
+        // It finishes in the background without touching the UI
+        this.stoppingRecorder?.detach();
+        this.stoppingRecorder = null;
+        this.segmentTranslator?.clear();
+        this.segmentTranslator = null;
         
         // Cleanup panel button with proper removal
         if (this.panelButton) {
@@ -101,6 +132,8 @@ export default class SpeechToTextExtension extends Extension {
         this.modelManager = null;
         
         // Clear settings reference
+        this.backendSettingsIds.forEach(id => this.settings.disconnect(id));
+        this.backendSettingsIds = [];
         this.settings = null;
         
         // Clear translator reference
@@ -109,20 +142,6 @@ export default class SpeechToTextExtension extends Extension {
         console.log('Speech to Text extension disabled and cleaned up');
     }
 
-    async _translateText(text) {
-        if (!this.translationManager || !text) {
-            throw new Error('Translation manager not available or empty text');
-        }
-        
-        try {
-            const result = await this.translationManager.translateText(text);
-            return result;
-        } catch (error) {
-            console.log(`Translation failed: ${error.message}`);
-            throw error;
-        }
-    }
-
     _setRecordingMode(mode) {
         if (!Utils.isValidRecordingMode(mode)) return;
         
@@ -139,7 +158,8 @@ export default class SpeechToTextExtension extends Extension {
     }
 
     _startRecording() {
-        if (this.isRecording) return;
+        // The previous backend may still be writing its last words
+        if (this.isRecording || this.stoppingRecorder?.stopping) return;
         
         try {
             this.audioRecorder = new AudioRecorder(this.path);
@@ -150,8 +170,36 @@ export default class SpeechToTextExtension extends Extension {
                 this.audioRecorder.setModelPath(currentModelPath);
             }
             
+            this.audioRecorder.setBackendOption('noise-reduction',
+                this.settings.get_boolean('noise-reduction'));
+            this.audioRecorder.setBackendOption('microphone-sensitivity',
+                this.settings.get_int('microphone-sensitivity'));
+            this.audioRecorder.setBackendOption('endpoint-profile',
+                this.settings.get_string('endpoint-profile'));
+            this.audioRecorder.setBackendOption('text-language',
+                this.settings.get_string('model-language'));
+            
+            // Offline translation runs in the backend on final segments
+            const backendTranslation = this._usesBackendTranslation();
+            this.audioRecorder.setBackendOption('translation', backendTranslation);
+            if (backendTranslation) {
+                this.audioRecorder.setBackendOption('translation-source',
+                    this.settings.get_string('translation-source-language'));
+                this.audioRecorder.setBackendOption('translation-target',
+                    this.settings.get_string('translation-target-language'));
+            }
+            
+            // Other services translate finalized segments from here
+            const segmentTranslator = this._usesRemoteTranslation()
+                ? new SegmentTranslator(this.translationManager,
+                    (caption) => this._onTextTranslated(caption, this.settings.get_string('translation-service')))
+                : null;
+            this.segmentTranslator = segmentTranslator;
+            
             this.audioRecorder.startRecording(this.recordingMode, {
-                onText: (text) => this._onTextRecognized(text),
+                onText: (transcript, update) => this._onTextRecognized(transcript, update),
+                onSegment: segmentTranslator ? (id, text) => segmentTranslator.add(id, text) : null,
+                onTranslation: backendTranslation ? (text) => this._onTextTranslated(text) : null,
                 onStatus: (status, type) => this._onRecordingStatus(status, type),
                 onAudioLevel: (level) => this._onAudioLevelChange(level)
             });
@@ -174,9 +222,16 @@ export default class SpeechToTextExtension extends Extension {
     _stopRecording() {
         if (!this.isRecording || !this.audioRecorder) return;
         
+        // Text keeps arriving until the backend has flushed and exited
         this.audioRecorder.stopRecording();
+        this.stoppingRecorder = this.audioRecorder;
         this.audioRecorder = null;
         
+        if (this.segmentTranslator) {
+            const { segments, requests, deduped } = this.segmentTranslator.stats;
+            console.log(`Segment translation: ${segments} segments, ${requests} requests, ${deduped} deduplicated`);
+        }
+        
         this.isRecording = false;
         this.panelButton.updateRecordingState(false);
         this.panelButton.resetToDefaultIcon();
@@ -187,50 +242,55 @@ export default class SpeechToTextExtension extends Extension {
         ));
     }
 
-    _onTextRecognized(text) {
-        // Immediate update with performance optimization
-        this.panelButton.updateText(text);
+    _onTextRecognized(transcript, { changes, final }) {
+        // The panel only shows committed text, so it does not repaint (or
+        // animate) while the recognizer is still revising the tail
+        this.panelButton.showTranscript(transcript);
         
-        // Update overlay immediately for real-time feedback
-        const statusText = Utils.formatStatusMessage(
-            `🔊 "${text}"`,
-            Constants.STATUS_TYPES.RECOGNIZED
-        );
-        this.overlay.updateText(statusText);
+        // Only the edited segments are redrawn, the tentative tail dimmed
+        this.overlay.showTranscript(transcript, changes);
         
-        // Handle translation if enabled (async, non-blocking)
-        if (this.settings.get_boolean('enable-translation') && 
-            this.settings.get_boolean('auto-translate') && text && text.length > 3) {
-            
-            this._translateText(text).then(translationResult => {
-                const displayText = this.translationManager.formatTranslationForDisplay(
-                    translationResult, 
-                    this.settings.get_boolean('show-original-text')
-                );
-                
-                this.overlay.updateText(Utils.formatStatusMessage(
-                    displayText,
-                    Constants.STATUS_TYPES.RECOGNIZED
-                ));
-                
-                // Update panel with translated text if configured
-                if (!this.settings.get_boolean('show-original-text')) {
-                    this.panelButton.updateText(translationResult.translated);
-                }
-            }).catch(error => {
-                // Silent fail for translation errors during real-time updates
-            });
-        }
+        // Translation is driven by onSegment, one request per batch of
+        // finalized segments rather than one per hypothesis
         
-        // Auto-copy if enabled (non-blocking, less frequent for partial updates)
-        if (this.settings.get_boolean('auto-copy') && text && text.length > 10) {
+        // Auto-copy if enabled (non-blocking, only once a segment is final)
+        if (final && this.settings.get_boolean('auto-copy')) {
             GLib.idle_add(GLib.PRIORITY_DEFAULT, () => {
-                Utils.copyToClipboard(text);
+                const text = transcript.text;
+                if (text.length > 10) Utils.copyToClipboard(text);
                 return GLib.SOURCE_REMOVE;
             });
         }
     }
 
+    _usesBackendTranslation() {
+        return this.settings.get_boolean('enable-translation') &&
+            this.settings.get_boolean('auto-translate') &&
+            this.settings.get_string('translation-service') === 'offline';
+    }
+
+    _usesRemoteTranslation() {
+        return this.translationManager &&
+            this.settings.get_boolean('enable-translation') &&
+            this.settings.get_boolean('auto-translate') &&
+            this.settings.get_string('translation-service') !== 'offline';
+    }
+
+    _onTextTranslated(translated, service = 'offline') {
+        const displayText = this.translationManager.formatTranslationForDisplay(
+            { original: (this.audioRecorder ?? this.stoppingRecorder)?.recognizedText ?? '', translated, service },
+            this.settings.get_boolean('show-original-text')
+        );
+        this.overlay.updateText(Utils.formatStatusMessage(
+            displayText,
+            Constants.STATUS_TYPES.RECOGNIZED
+        ));
+        
+        if (!this.settings.get_boolean('show-original-text')) {
+            this.panelButton.updateText(translated);
+        }
+    }
+
     _onRecordingStatus(status, type) {
         this.overlay.updateText(Utils.formatStatusMessage(status, type));
         
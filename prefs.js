@@ -86,6 +86,24 @@ export default class STTPreferences extends ExtensionPreferences {
         });
         settings.bind('noise-reduction', noiseReductionRow, 'active', Gio.SettingsBindFlags.DEFAULT);
         audioGroup.add(noiseReductionRow);
+
+        // Endpoint profile
+        const endpointRow = new Adw.ComboRow({
+            title: _('Sentence Endings'),
+            subtitle: _('How long a pause ends a sentence')
+        });
+        const endpointModel = new Gtk.StringList();
+        [_('Model Default'), _('Live Captions (short)'), _('Dictation (long)')].forEach(option => endpointModel.append(option));
+        endpointRow.set_model(endpointModel);
+        
+        const profiles = ['model', 'captions', 'dictation'];
+        const profileIndex = profiles.indexOf(settings.get_string('endpoint-profile'));
+        endpointRow.set_selected(profileIndex >= 0 ? profileIndex : 0);
+        
+        endpointRow.connect('notify::selected', () => {
+            settings.set_string('endpoint-profile', profiles[endpointRow.get_selected()]);
+        });
+        audioGroup.add(endpointRow);
     }
 
     _createModelPage(window, settings) {
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Feed-forward automatic gain control with a peak limiter.
+//
+// The level detector runs on the RMS of 4 ms sub-blocks (64 samples at
+// 16 kHz), smoothed with separate attack and release time constants. The
+// gain needed to bring that level to the target is capped by the
+// microphone sensitivity (0 -> no boost, 100 -> +40 dB), held while the
+// input is below the gate so background noise is not pumped up, and
+// ramped linearly across each sub-block. A hard ceiling at -1 dBFS catches
+// transients the detector has not reacted to yet. No lookahead, so the
+// stage adds no latency.
+//
+// Samples are floats in int16 scale; processing is in place and does not
+// allocate.
+class AutomaticGainControl {
+public:
+    static constexpr size_t SUB_BLOCK = 64;
+    static constexpr size_t TRAJECTORY = 64;     // recent gain values kept for metrics
+
+    void configure(int rate) {
+        sampleRate = rate;
+        updateCoefficients();
+        reset();
+    }
+
+    void reset() {
+        level = 0.0f;
+        gain = 1.0f;
+        step = 0.0f;
+        fill = 0;
+        energy = 0.0f;
+        trajectoryPos = 0;
+        trajectoryCount = 0;
+        blocks = 0;
+        gainDbSum = 0.0;
+        gainDbMin = 0.0f;
+        gainDbMax = 0.0f;
+        limited = 0;
+    }
+
+    void setTargetDb(float db) {
+        target = FULL_SCALE * std::pow(10.0f, db / 20.0f);
+    }
+
+    void setSensitivity(int sensitivity) {
+        sensitivity = std::max(0, std::min(100, sensitivity));
+        maxGain = std::pow(10.0f, (MAX_BOOST_DB * sensitivity / 100.0f) / 20.0f);
+    }
+
+    void setTimes(float attackMs, float releaseMs) {
+        attackTime = std::max(attackMs, 0.1f);
+        releaseTime = std::max(releaseMs, 0.1f);
+        updateCoefficients();
+    }
+
+    void process(float* samples, size_t count) {
+        size_t i = 0;
+        while (i < count) {
+            // Apply the current ramp up to the next sub-block boundary
+            size_t run = std::min(count - i, SUB_BLOCK - fill);
+            float g = gain;
+            for (size_t j = 0; j < run; j++) {
+                float x = samples[i + j];
+                energy += x * x;
+                float y = x * g;
+                g += step;
+                if (y > CEILING) {
+                    y = CEILING;
+                    limited++;
+                } else if (y < -CEILING) {
+                    y = -CEILING;
+                    limited++;
+                }
+                samples[i + j] = y;
+            }
+            gain = g;
+            fill += run;
+            i += run;
+
+            if (fill == SUB_BLOCK) {
+                updateGain();
+                fill = 0;
+                energy = 0.0f;
+            }
+        }
+    }
+
+    float currentGainDb() const { return toDb(gain); }
+    float minGainDb() const { return gainDbMin; }
+    float maxGainDb() const { return gainDbMax; }
+    double meanGainDb() const { return blocks ? gainDbSum / blocks : 0.0; }
+    uint64_t limitedSamples() const { return limited; }
+    uint64_t blockCount() const { return blocks; }
+
+    // Most recent gain values in dB, oldest first, one per TRAJECTORY_STRIDE
+    // sub-blocks (~128 ms at 16 kHz).
+    template <typename Visitor>
+    void forEachTrajectoryPoint(Visitor&& visit) const {
+        size_t start = (trajectoryPos + TRAJECTORY - trajectoryCount) % TRAJECTORY;
+        for (size_t k = 0; k < trajectoryCount; k++) {
+            visit(trajectory[(start + k) % TRAJECTORY]);
+        }
+    }
+
+private:
+    static constexpr float FULL_SCALE = 32768.0f;
+    static constexpr float CEILING = 32768.0f * 0.891f;      // -1 dBFS
+    static constexpr float GATE = 32768.0f * 0.001f;         // -60 dBFS
+    static constexpr float MAX_BOOST_DB = 40.0f;
+    static constexpr float MIN_GAIN = 0.1f;                  // at most -20 dB of reduction
+    static constexpr size_t TRAJECTORY_STRIDE = 32;
+
+    int sampleRate = 16000;
+    float target = FULL_SCALE * 0.126f;                      // -18 dBFS
+    float maxGain = 10.0f;                                   // sensitivity 50: +20 dB
+    float attackTime = 10.0f;
+    float releaseTime = 400.0f;
+    float attack = 0.0f;
+    float release = 0.0f;
+
+    float level = 0.0f;
+    float gain = 1.0f;
+    float step = 0.0f;
+    float energy = 0.0f;
+    size_t fill = 0;
+
+    std::array<float, TRAJECTORY> trajectory{};
+    size_t trajectoryPos = 0;
+    size_t trajectoryCount = 0;
+    uint64_t blocks = 0;
+    double gainDbSum = 0.0;
+    float gainDbMin = 0.0f;
+    float gainDbMax = 0.0f;
+    uint64_t limited = 0;
+
+    static float toDb(float g) {
+        return 20.0f * std::log10(std::max(g, 1e-6f));
+    }
+
+    void updateCoefficients() {
+        float blockMs = 1000.0f * SUB_BLOCK / sampleRate;
+        attack = 1.0f - std::exp(-blockMs / attackTime);
+        release = 1.0f - std::exp(-blockMs / releaseTime);
+    }
+
+    // Runs once per sub-block: smooth the level, pick the gain for the end of
+    // the next sub-block and set the per-sample ramp towards it.
+    void updateGain() {
+        float rms = std::sqrt(energy / SUB_BLOCK);
+        level += (rms > level ? attack : release) * (rms - level);
+
+        float desired = gain;
+        if (level > GATE) {
+            desired = std::max(MIN_GAIN, std::min(maxGain, target / level));
+        }
+        // Gain drops with the attack constant and recovers with the release one
+        float next = gain + (desired < gain ? attack : release) * (desired - gain);
+        step = (next - gain) / SUB_BLOCK;
+
+        float db = toDb(gain);
+        if (blocks == 0) {
+            gainDbMin = gainDbMax = db;
+        } else {
+            gainDbMin = std::min(gainDbMin, db);
+            gainDbMax = std::max(gainDbMax, db);
+        }
+        gainDbSum += db;
+        if (blocks % TRAJECTORY_STRIDE == 0) {
+            trajectory[trajectoryPos] = db;
+            trajectoryPos = (trajectoryPos + 1) % TRAJECTORY;
+            trajectoryCount = std::min(trajectoryCount + 1, TRAJECTORY);
+        }
+        blocks++;
+    }
+};
@@ -0,0 +1,479 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "async_writer.h"
+#include "dsp_kernels.h"
+#include "flac_encoder.h"
+#include "recorder_settings.h"
+
+struct ArchiveStats {
+    uint64_t samplesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t droppedSamples = 0;
+    double encodeSeconds = 0.0;
+    int segments = 0;
+
+    double compressionRatio() const {
+        return bytesOut ? static_cast<double>(samplesIn * sizeof(int16_t)) / bytesOut : 0.0;
+    }
+};
+
+// Compresses captured audio on a worker thread while recording is running.
+//
+// The capture thread hands samples over through a bounded ring of
+// pre-allocated blocks and never waits on the encoder: if the ring is full the
+// samples are dropped and counted instead. Formats:
+//   wav  - streaming RIFF, header patched on every sync and on close
+//   flac - built-in encoder (flac_encoder.h), lossless
+//   opus - piped through `opusenc`, lossy at the configured bitrate; falls
+//          back to flac when opusenc is not installed
+//
+// With segment-seconds > 0 the archive becomes a directory of rolling
+// segments plus a manifest.jsonl that gets one line (fsync'd) per finished
+// segment, so a crash loses at most the segment being written and batch jobs
+// can pick up finished segments while recording continues.
+//
+// WAV and FLAC output and the manifest go through the AsyncWriter; the
+// encoder only waits for it when more than writer-queue-kb is queued, and
+// then the ring in front of it absorbs the stall.
+class ArchiveEncoder {
+public:
+    static constexpr size_t BLOCK_SAMPLES = 4096;
+
+    ~ArchiveEncoder() {
+        finish();
+    }
+
+    bool start(const std::string& basename, const RecorderSettings& settings, int sampleRate, AsyncWriter& writer) {
+        this->writer = &writer;
+        format = settings.archiveFormat;
+        if (format == "opus" && !onPath("opusenc")) {
+            std::cerr << "⚠️ opusenc not found; archiving as flac instead" << std::endl;
+            format = "flac";
+        }
+        opusBitrateKbps = settings.opusBitrateKbps;
+        this->sampleRate = sampleRate;
+        segmentSamples = static_cast<uint64_t>(settings.segmentSeconds) * sampleRate;
+        syncSamples = static_cast<uint64_t>(settings.fsyncSeconds) * sampleRate;
+        segmentIndex = 0;
+        segmentStart = 0;
+        stats = ArchiveStats();
+
+        if (segmentSamples > 0) {
+            directory = basename;
+            if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+                std::cerr << "❌ Could not create archive directory: " << directory << std::endl;
+                return false;
+            }
+            manifest = writer.open(directory + "/manifest.jsonl", false);
+            target = directory;
+        } else {
+            directory.clear();
+            target = basename + "." + format;
+        }
+
+        if (!openSegment()) {
+            writer.close(manifest);
+            manifest = -1;
+            return false;
+        }
+
+        slots.assign(std::max<size_t>(settings.archiveQueueBlocks, 2), std::vector<int16_t>());
+        for (auto& slot : slots) {
+            slot.reserve(BLOCK_SAMPLES);
+        }
+        head = tail = filled = 0;
+        producerHasSlot = false;
+        stopping = false;
+        active = true;
+        worker = std::thread(&ArchiveEncoder::run, this);
+        return true;
+    }
+
+    // Called from the capture thread. Never blocks on the encoder. Float
+    // input (int16 scale) is quantized while being copied into the block.
+    template <typename T>
+    void push(const T* samples, size_t count) {
+        if (!active) return;
+
+        while (count > 0) {
+            if (!producerHasSlot) {
+                std::lock_guard<std::mutex> lock(mutex);
+                producerHasSlot = filled < slots.size();
+            }
+            if (!producerHasSlot) {
+                stats.droppedSamples += count;
+                return;
+            }
+
+            std::vector<int16_t>& block = slots[head];
+            size_t used = block.size();
+            size_t take = std::min(count, BLOCK_SAMPLES - used);
+            block.resize(used + take);
+            copySamples(samples, take, block.data() + used);
+            samples += take;
+            count -= take;
+
+            if (block.size() == BLOCK_SAMPLES) {
+                publish();
+            }
+        }
+    }
+
+    // Drains the queue, closes the last segment and prints the encode report.
+    void finish() {
+        if (!active) return;
+
+        if (producerHasSlot && !slots[head].empty()) {
+            publish();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_one();
+        if (worker.joinable()) worker.join();   // closes the last segment
+
+        writer->close(manifest);
+        manifest = -1;
+        active = false;
+
+        report();
+    }
+
+    // File, or segment directory, that the session is archived to.
+    const std::string& path() const { return target; }
+    const ArchiveStats& statistics() const { return stats; }
+
+private:
+    static constexpr size_t WAV_HEADER_BYTES = 44;
+
+    std::string format;
+    std::string directory;
+    std::string target;
+    std::string segmentFile;
+    int opusBitrateKbps = 24;
+    int sampleRate = 16000;
+    uint64_t segmentSamples = 0;    // 0 = single file
+    uint64_t syncSamples = 0;       // 0 = only on close
+    uint64_t segmentWritten = 0;
+    uint64_t segmentBytes = 0;
+    uint64_t segmentStart = 0;
+    uint64_t sinceSync = 0;
+    int segmentIndex = 0;
+    AsyncWriter* writer = nullptr;
+    int sink = -1;                  // wav/flac segment, in the writer
+    FILE* file = nullptr;           // opusenc pipe
+    int manifest = -1;
+    FlacEncoder flac;
+    std::vector<uint8_t> output;
+    char headerBytes[WAV_HEADER_BYTES];
+    ArchiveStats stats;
+    bool active = false;
+
+    std::vector<std::vector<int16_t>> slots;
+    size_t head = 0;        // slot being filled by the producer
+    size_t tail = 0;        // next slot for the worker
+    size_t filled = 0;      // published, not yet encoded
+    bool producerHasSlot = false;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread worker;
+
+    static void copySamples(const int16_t* in, size_t count, int16_t* out) {
+        std::copy(in, in + count, out);
+    }
+
+    static void copySamples(const float* in, size_t count, int16_t* out) {
+        dsp::floatToInt16(in, count, out);
+    }
+
+    static bool onPath(const std::string& program) {
+        const char* path = getenv("PATH");
+        std::string directories = path ? path : "/usr/bin:/bin";
+        size_t begin = 0;
+        while (begin <= directories.size()) {
+            size_t end = directories.find(':', begin);
+            if (end == std::string::npos) end = directories.size();
+            std::string directory = end > begin ? directories.substr(begin, end - begin) : ".";
+            if (access((directory + "/" + program).c_str(), X_OK) == 0) return true;
+            begin = end + 1;
+        }
+        return false;
+    }
+
+    // Single-quoted for /bin/sh; an embedded ' becomes '\''.
+    static std::string shellQuoted(const std::string& text) {
+        std::string quoted = "'";
+        for (char c : text) {
+            if (c == '\'') quoted += "'\\''"; else quoted += c;
+        }
+        return quoted + "'";
+    }
+
+    void publish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            filled++;
+            head = (head + 1) % slots.size();
+            producerHasSlot = false;
+        }
+        cv.notify_one();
+    }
+
+    void run() {
+        // The opusenc pipe is only written and closed on this thread, so a
+        // dead opusenc fails the write with EPIPE instead of ending the process
+        sigset_t pipeSignal;
+        sigemptyset(&pipeSignal);
+        sigaddset(&pipeSignal, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipeSignal, nullptr);
+
+        while (true) {
+            std::vector<int16_t>* block;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return filled > 0 || stopping; });
+                if (filled == 0) {
+                    lock.unlock();
+                    closeSegment();
+                    return;
+                }
+                block = &slots[tail];
+            }
+
+            writer->waitForRoom();
+            auto begin = std::chrono::steady_clock::now();
+            const int16_t* samples = block->data();
+            size_t count = block->size();
+            while (count > 0 && (file || sink >= 0)) {
+                size_t take = count;
+                if (segmentSamples > 0) {
+                    take = std::min<uint64_t>(count, segmentSamples - segmentWritten);
+                }
+                encode(samples, take);
+                samples += take;
+                count -= take;
+
+                if (segmentSamples > 0 && segmentWritten == segmentSamples) {
+                    closeSegment();
+                    openSegment();
+                } else if (syncSamples > 0 && sinceSync >= syncSamples) {
+                    syncSegment();
+                }
+            }
+            stats.encodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            stats.samplesIn += block->size();
+            block->clear();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            tail = (tail + 1) % slots.size();
+            filled--;
+        }
+    }
+
+    bool openSegment() {
+        if (directory.empty()) {
+            segmentFile = target;
+        } else {
+            char name[32];
+            snprintf(name, sizeof(name), "/segment_%05d.", segmentIndex);
+            segmentFile = directory + name + format;
+        }
+
+        if (format == "opus") {
+            std::string command = "opusenc --quiet --raw --raw-bits=16 --raw-chan=1 --raw-rate=" +
+                                  std::to_string(sampleRate) + " --bitrate " +
+                                  std::to_string(opusBitrateKbps) + " - " + shellQuoted(segmentFile);
+            file = popen(command.c_str(), "w");
+        } else {
+            sink = writer->open(segmentFile, true);
+        }
+        if (!file && sink < 0) {
+            std::cerr << "❌ Could not create archive file: " << segmentFile << std::endl;
+            return false;
+        }
+
+        segmentWritten = 0;
+        segmentBytes = 0;
+        sinceSync = 0;
+        if (format == "wav") {
+            writer->append(sink, wavHeader());
+            segmentBytes += WAV_HEADER_BYTES;
+            stats.bytesOut += WAV_HEADER_BYTES;
+        } else if (format == "flac") {
+            flac = FlacEncoder(sampleRate);
+            output.clear();
+            flac.writeHeader(output);
+            writeOutput();
+        }
+        return true;
+    }
+
+    void closeSegment() {
+        if (!file && sink < 0) return;
+
+        bool written = true;
+        if (format == "opus") {
+            bool failed = ferror(file) != 0;
+            int status = pclose(file);
+            struct stat st;
+            if (failed || status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                std::cerr << "❌ opusenc failed, segment not archived: " << segmentFile << std::endl;
+                written = false;
+            } else if (stat(segmentFile.c_str(), &st) == 0) {
+                segmentBytes = st.st_size;
+                stats.bytesOut += segmentBytes;
+            }
+        } else {
+            if (format == "flac") {
+                output.clear();
+                flac.flush(output);
+                writeOutput();
+            }
+            patchHeader();
+            writer->sync(sink);
+            writer->close(sink);
+        }
+        file = nullptr;
+        sink = -1;
+
+        if (written && (segmentWritten > 0 || segmentIndex == 0)) {
+            // The manifest may only list it once it is on disk
+            if (manifest >= 0) writer->flush();
+            stats.segments++;
+            appendManifest();
+        } else {
+            unlink(segmentFile.c_str());   // rolled over right before stop, or failed
+        }
+        segmentStart += segmentWritten;
+        segmentIndex++;
+    }
+
+    // Makes everything written so far durable and decodable: WAV sizes are
+    // patched in place, FLAC frames are self-delimiting so a torn tail only
+    // costs the last frame.
+    void syncSegment() {
+        if (format != "opus") {
+            patchHeader();
+            writer->sync(sink);
+        }
+        sinceSync = 0;
+    }
+
+    void appendManifest() {
+        if (manifest < 0) return;
+
+        const char* name = segmentFile.c_str() + directory.size() + 1;
+        char line[512];
+        int length = snprintf(line, sizeof(line),
+                              "{\"segment\":%d,\"file\":\"%s\",\"format\":\"%s\",\"sample_rate\":%d,"
+                              "\"start_sample\":%llu,\"samples\":%llu,\"bytes\":%llu}\n",
+                              segmentIndex, name, format.c_str(), sampleRate,
+                              static_cast<unsigned long long>(segmentStart),
+                              static_cast<unsigned long long>(segmentWritten),
+                              static_cast<unsigned long long>(segmentBytes));
+        writer->append(manifest, std::string_view(line, std::min<size_t>(length, sizeof(line) - 1)));
+        writer->sync(manifest);
+    }
+
+    void encode(const int16_t* samples, size_t count) {
+        if (format == "flac") {
+            output.clear();
+            flac.encode(samples, count, output);
+            writeOutput();
+        } else if (file) {
+            fwrite(samples, sizeof(int16_t), count, file);
+        } else {
+            writer->append(sink, std::string_view(reinterpret_cast<const char*>(samples), count * sizeof(int16_t)));
+            if (format == "wav") {
+                segmentBytes += count * sizeof(int16_t);
+                stats.bytesOut += count * sizeof(int16_t);
+            }
+        }
+        segmentWritten += count;
+        sinceSync += count;
+    }
+
+    void writeOutput() {
+        if (output.empty()) return;
+        writer->append(sink, std::string_view(reinterpret_cast<const char*>(output.data()), output.size()));
+        segmentBytes += output.size();
+        stats.bytesOut += output.size();
+    }
+
+    // Rewrites the header in place with the sizes so far.
+    void patchHeader() {
+        if (format == "wav") {
+            writer->writeAt(sink, 0, wavHeader());
+        } else if (format == "flac") {
+            output.clear();
+            flac.writeHeader(output);
+            writer->writeAt(sink, 0, std::string_view(reinterpret_cast<const char*>(output.data()), output.size()));
+        }
+    }
+
+    std::string_view wavHeader() {
+        struct WAVHeader {
+            char chunkID[4] = {'R', 'I', 'F', 'F'};
+            uint32_t chunkSize;
+            char format[4] = {'W', 'A', 'V', 'E'};
+            char subchunk1ID[4] = {'f', 'm', 't', ' '};
+            uint32_t subchunk1Size = 16;
+            uint16_t audioFormat = 1;
+            uint16_t numChannels = 1;
+            uint32_t sampleRate;
+            uint32_t byteRate;
+            uint16_t blockAlign = 2;
+            uint16_t bitsPerSample = 16;
+            char subchunk2ID[4] = {'d', 'a', 't', 'a'};
+            uint32_t subchunk2Size;
+        };
+
+        static_assert(sizeof(WAVHeader) == WAV_HEADER_BYTES, "packed RIFF header");
+        WAVHeader header;
+        header.sampleRate = sampleRate;
+        header.byteRate = sampleRate * sizeof(int16_t);
+        header.subchunk2Size = segmentWritten * sizeof(int16_t);
+        header.chunkSize = 36 + header.subchunk2Size;
+        memcpy(headerBytes, &header, sizeof(header));
+        return std::string_view(headerBytes, sizeof(header));
+    }
+
+    void report() {
+        double audioSeconds = static_cast<double>(stats.samplesIn) / sampleRate;
+        std::cout << "📦 Archive " << format << ": " << (stats.samplesIn * sizeof(int16_t) / 1024) << "KB -> "
+                  << (stats.bytesOut / 1024) << "KB";
+        if (stats.bytesOut) {
+            std::cout << " (ratio " << stats.compressionRatio() << "x)";
+        }
+        if (segmentSamples > 0) {
+            std::cout << " in " << stats.segments << " segments";
+        }
+        if (audioSeconds > 0) {
+            std::cout << ", encode " << (stats.encodeSeconds * 1000.0) << "ms for " << audioSeconds
+                      << "s audio (" << (100.0 * stats.encodeSeconds / audioSeconds) << "% of realtime)";
+        }
+        std::cout << std::endl;
+        if (stats.droppedSamples) {
+            std::cerr << "⚠️ Archive queue full, dropped " << stats.droppedSamples << " samples" << std::endl;
+        }
+    }
+};
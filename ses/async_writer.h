@@ -0,0 +1,730 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <initializer_list>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "recorder_settings.h"
+
+// <linux/fs.h>, included by io_uring.h, defines it; FlacEncoder has a member
+// of that name
+#undef BLOCK_SIZE
+
+// Carries file output off the threads that produce it, so a slow or
+// network-mounted home directory stalls the writer instead of the recording
+// thread (status and transcript files) or the archive encoder.
+//
+// Producers queue operations per file and return: append, replace (the
+// whole content; a replacement not yet started is dropped in favour of a
+// newer one), write at an offset, fsync and close. One writer thread turns
+// them into I/O. Each file has at most one operation in flight, so a file
+// is written in the order it was queued; different files are written in
+// parallel, and every round submits the next operation of each idle file
+// together. Data is copied into one of `writer-buffers` fixed buffers for
+// the write.
+//
+// With io_uring (when the kernel allows it) the buffers are registered
+// once, writes are IORING_OP_WRITE_FIXED and a round is one io_uring_enter
+// call. Otherwise `writer-threads` threads run pwrite/fsync.
+//
+// Only open() touches the filesystem on the caller's thread. Queueing takes
+// a short lock and copies the bytes into a recycled string, so steady-state
+// producers do not allocate.
+class AsyncWriter {
+public:
+    ~AsyncWriter() {
+        stop();
+    }
+
+    void start(const RecorderSettings& settings) {
+        if (running) return;
+        bufferBytes = std::max<size_t>(4, settings.writerBufferKb) * 1024;
+        bufferCount = std::max<size_t>(2, std::min<size_t>(settings.writerBuffers, MAX_FILES));
+        queueLimit = std::max<size_t>(bufferBytes, settings.writerQueueKb * 1024);
+        memory.reset(new char[bufferBytes * bufferCount]);
+        freeBuffers.clear();
+        for (size_t i = 0; i < bufferCount; i++) freeBuffers.push_back(static_cast<int>(bufferCount - 1 - i));
+        files.assign(MAX_FILES, File());
+        spare.reserve(MAX_SPARE);
+        kickFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        stats = Stats();
+        stopping = false;
+        kicked = false;
+
+        backend.reset();
+        if (settings.writerBackend == "io_uring") {
+            auto ring = std::make_unique<UringBackend>();
+            if (ring->setup(memory.get(), bufferBytes, bufferCount, kickFd)) {
+                backend = std::move(ring);
+            } else {
+                std::cerr << "⚠️ Writer: io_uring unavailable (" << strerror(errno) << "), using threads" << std::endl;
+            }
+        } else if (settings.writerBackend != "threads") {
+            std::cerr << "⚠️ Unknown writer backend: " << settings.writerBackend << ", using threads" << std::endl;
+        }
+        if (!backend) backend = std::make_unique<ThreadBackend>(std::max(1, settings.writerThreads), kickFd);
+
+        running = true;
+        worker = std::thread(&AsyncWriter::run, this);
+    }
+
+    // Writes everything queued, closes every file and stops the thread.
+    void stop() {
+        if (!running) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        kick();
+        worker.join();
+        for (File& file : files) {
+            if (file.fd >= 0) ::close(file.fd);
+        }
+        files.clear();
+        backend.reset();
+        ::close(kickFd);
+        kickFd = -1;
+        running = false;
+    }
+
+    bool active() const { return running; }
+
+    // Opens `path` for writing; appends go to its end (0 when truncated).
+    // Returns a handle, or -1.
+    int open(const std::string& path, bool truncate) {
+        if (!running) return -1;
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+        if (fd < 0) return -1;
+        struct stat st;
+        uint64_t end = (!truncate && fstat(fd, &st) == 0) ? static_cast<uint64_t>(st.st_size) : 0;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < files.size(); i++) {
+            if (files[i].used) continue;
+            files[i] = File();
+            files[i].used = true;
+            files[i].fd = fd;
+            files[i].end = end;
+            return static_cast<int>(i);
+        }
+        ::close(fd);
+        return -1;
+    }
+
+    void append(int file, std::initializer_list<std::string_view> parts) {
+        queue(file, Kind::Append, parts, 0);
+    }
+
+    void append(int file, std::string_view data) {
+        queue(file, Kind::Append, {data}, 0);
+    }
+
+    void replace(int file, std::initializer_list<std::string_view> parts) {
+        queue(file, Kind::Replace, parts, 0);
+    }
+
+    void replace(int file, std::string_view data) {
+        queue(file, Kind::Replace, {data}, 0);
+    }
+
+    void writeAt(int file, uint64_t offset, std::string_view data) {
+        queue(file, Kind::WriteAt, {data}, offset);
+    }
+
+    void sync(int file) {
+        queue(file, Kind::Sync, {}, 0);
+    }
+
+    // Closes the file once what was queued before has been written; the
+    // handle is free for reuse after that.
+    void close(int file) {
+        queue(file, Kind::Close, {}, 0);
+    }
+
+    // For producers that may wait (the archive encoder, not the recording
+    // thread): blocks while more than writer-queue-kb is queued.
+    void waitForRoom() {
+        if (!running) return;
+        std::unique_lock<std::mutex> lock(mutex);
+        if (queuedBytes <= queueLimit) return;
+        stats.waits++;
+        progress.wait(lock, [this] { return queuedBytes <= queueLimit; });
+    }
+
+    // Blocks until everything queued so far has been written.
+    void flush() {
+        if (!running) return;
+        std::unique_lock<std::mutex> lock(mutex);
+        progress.wait(lock, [this] { return queuedOps == 0 && settling == 0; });
+    }
+
+    // For the control socket's `metrics` command.
+    std::string metrics() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::ostringstream line;
+        line << "writer-queued-bytes=" << queuedBytes << " writer-queued-ops=" << queuedOps
+             << " writer-in-flight=" << inFlight << " writer-max-queued-bytes=" << stats.maxQueuedBytes
+             << " writer-max-in-flight=" << stats.maxInFlight;
+        return line.str();
+    }
+
+    // Prints and clears the counters since the last report.
+    void report() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!backend || stats.writes + stats.syncs == 0) return;
+        std::cout << "💽 Writer (" << backend->name() << ", " << bufferCount << " x " << bufferBytes / 1024
+                  << " KB buffers): " << stats.writes << " writes, " << stats.syncs << " fsyncs in "
+                  << stats.submissions << " submissions ("
+                  << static_cast<double>(stats.writes + stats.syncs) / std::max<uint64_t>(1, stats.submissions)
+                  << " per call), up to " << stats.maxInFlight << " in flight and "
+                  << stats.maxQueuedBytes / 1024.0 << " KB queued, slowest " << stats.maxMicros / 1000.0
+                  << " ms, " << stats.waits << " encoder waits, " << stats.failures << " failed" << std::endl;
+        stats = Stats();
+    }
+
+private:
+    static constexpr size_t MAX_FILES = 16;
+    static constexpr size_t MAX_SPARE = 64;
+    static constexpr uint64_t KICK = ~0ull;       // user_data of the wake-up poll
+
+    enum class Kind { Append, Replace, WriteAt, Sync, Close };
+
+    struct Op {
+        Kind kind = Kind::Append;
+        std::string data;
+        uint64_t offset = 0;                      // where data starts, fixed when the op starts
+        size_t done = 0;                          // bytes of data written
+        bool started = false;
+    };
+
+    struct File {
+        bool used = false;
+        int fd = -1;
+        uint64_t end = 0;                         // where the next append starts
+        std::vector<Op> ops;                      // FIFO from `head`; storage reused
+        size_t head = 0;
+        bool busy = false;                        // ops[head] is in flight
+        int buffer = -1;
+        size_t length = 0;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    // One write or fsync handed to the backend; `tag` is the file.
+    struct Request {
+        uint64_t tag;
+        int fd;
+        bool write;
+        int buffer;
+        char* data;
+        size_t length;
+        uint64_t offset;
+    };
+
+    struct Completion {
+        uint64_t tag;
+        int64_t result;
+    };
+
+    struct Stats {
+        uint64_t writes = 0;
+        uint64_t syncs = 0;
+        uint64_t submissions = 0;
+        uint64_t failures = 0;
+        uint64_t waits = 0;
+        size_t maxInFlight = 0;
+        size_t maxQueuedBytes = 0;
+        double maxMicros = 0.0;
+    };
+
+    class Backend {
+    public:
+        virtual ~Backend() = default;
+        virtual const char* name() const = 0;
+        virtual void submit(const std::vector<Request>& requests) = 0;
+        // Blocks until something completes or the kick eventfd fires.
+        virtual void wait(std::vector<Completion>& completed) = 0;
+    };
+
+    // Raw io_uring (no liburing): one SQ/CQ pair, buffers registered once,
+    // a POLL_ADD on the kick eventfd so new work ends a wait.
+    class UringBackend : public Backend {
+    public:
+        ~UringBackend() override {
+            if (ringFd < 0) return;
+            if (sqRing != MAP_FAILED) munmap(sqRing, sqRingBytes);
+            if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqRingBytes);
+            if (sqes != MAP_FAILED) munmap(sqes, sqeBytes);
+            ::close(ringFd);
+        }
+
+        bool setup(char* memory, size_t bufferBytes, size_t count, int kick) {
+            kickFd = kick;
+            io_uring_params params;
+            memset(&params, 0, sizeof(params));
+            ringFd = static_cast<int>(syscall(__NR_io_uring_setup, ENTRIES, &params));
+            if (ringFd < 0) return false;
+
+            sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single) sqRingBytes = cqRingBytes = std::max(sqRingBytes, cqRingBytes);
+            sqRing = mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                          IORING_OFF_SQ_RING);
+            if (sqRing == MAP_FAILED) return false;
+            cqRing = single ? sqRing
+                            : mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                                   IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) return false;
+            sqeBytes = params.sq_entries * sizeof(io_uring_sqe);
+            sqes = mmap(nullptr, sqeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED) return false;
+
+            char* sq = static_cast<char*>(sqRing);
+            sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            char* cq = static_cast<char*>(cqRing);
+            cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            std::vector<iovec> buffers(count);
+            for (size_t i = 0; i < count; i++) buffers[i] = {memory + i * bufferBytes, bufferBytes};
+            return syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS, buffers.data(),
+                           static_cast<unsigned>(count)) == 0;
+        }
+
+        const char* name() const override { return "io_uring"; }
+
+        void submit(const std::vector<Request>& requests) override {
+            unsigned tail = *sqTail;
+            unsigned queued = 0;
+            if (!polling) {
+                io_uring_sqe& sqe = next(tail, queued);
+                sqe.opcode = IORING_OP_POLL_ADD;
+                sqe.fd = kickFd;
+                sqe.poll_events = POLLIN;
+                sqe.user_data = KICK;
+                polling = true;
+            }
+            for (const Request& request : requests) {
+                io_uring_sqe& sqe = next(tail, queued);
+                sqe.fd = request.fd;
+                sqe.user_data = request.tag;
+                if (request.write) {
+                    sqe.opcode = IORING_OP_WRITE_FIXED;
+                    sqe.addr = reinterpret_cast<uint64_t>(request.data);
+                    sqe.len = static_cast<uint32_t>(request.length);
+                    sqe.off = request.offset;
+                    sqe.buf_index = static_cast<uint16_t>(request.buffer);
+                } else {
+                    sqe.opcode = IORING_OP_FSYNC;
+                }
+            }
+            if (queued == 0) return;
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+            while (syscall(__NR_io_uring_enter, ringFd, queued, 0, 0, nullptr, 0) < 0 && errno == EINTR) {}
+        }
+
+        void wait(std::vector<Completion>& completed) override {
+            if (*cqHead == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                while (syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0
+                       && errno == EINTR) {}
+            }
+            unsigned head = *cqHead;
+            unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++) {
+                const io_uring_cqe& cqe = cqes[head & cqMask];
+                if (cqe.user_data == KICK) {
+                    polling = false;
+                    uint64_t count;
+                    if (::read(kickFd, &count, sizeof(count)) < 0) {}
+                } else {
+                    completed.push_back({cqe.user_data, cqe.res});
+                }
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+
+    private:
+        static constexpr unsigned ENTRIES = 2 * MAX_FILES;   // one op in flight per file, plus the poll
+
+        int ringFd = -1;
+        int kickFd = -1;
+        bool polling = false;
+        void* sqRing = MAP_FAILED;
+        void* cqRing = MAP_FAILED;
+        void* sqes = MAP_FAILED;
+        size_t sqRingBytes = 0;
+        size_t cqRingBytes = 0;
+        size_t sqeBytes = 0;
+        unsigned* sqTail = nullptr;
+        unsigned sqMask = 0;
+        unsigned* sqArray = nullptr;
+        unsigned* cqHead = nullptr;
+        unsigned* cqTail = nullptr;
+        unsigned cqMask = 0;
+        io_uring_cqe* cqes = nullptr;
+
+        io_uring_sqe& next(unsigned& tail, unsigned& queued) {
+            unsigned index = tail & sqMask;
+            io_uring_sqe& sqe = static_cast<io_uring_sqe*>(sqes)[index];
+            memset(&sqe, 0, sizeof(sqe));
+            sqArray[index] = index;
+            tail++;
+            queued++;
+            return sqe;
+        }
+    };
+
+    // Fallback: pwrite/fsync on a few threads, completions handed back
+    // through the kick eventfd.
+    class ThreadBackend : public Backend {
+    public:
+        ThreadBackend(int threads, int kick) : kickFd(kick) {
+            for (int i = 0; i < threads; i++) workers.emplace_back(&ThreadBackend::run, this);
+            label = "threads x" + std::to_string(threads);
+        }
+
+        ~ThreadBackend() override {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            ready.notify_all();
+            for (auto& thread : workers) thread.join();
+        }
+
+        const char* name() const override { return label.c_str(); }
+
+        void submit(const std::vector<Request>& requests) override {
+            if (requests.empty()) return;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.insert(jobs.end(), requests.begin(), requests.end());
+            }
+            ready.notify_all();
+        }
+
+        void wait(std::vector<Completion>& completed) override {
+            while (true) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!done.empty()) {
+                        completed.insert(completed.end(), done.begin(), done.end());
+                        done.clear();
+                    }
+                }
+                uint64_t count;
+                bool kicked = ::read(kickFd, &count, sizeof(count)) == sizeof(count);
+                if (kicked || !completed.empty()) return;
+                pollfd descriptor = {kickFd, POLLIN, 0};
+                poll(&descriptor, 1, -1);
+            }
+        }
+
+    private:
+        int kickFd;
+        std::string label;
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::vector<Request> jobs;
+        std::vector<Completion> done;
+        bool stopping = false;
+
+        void run() {
+            while (true) {
+                Request job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [this] { return !jobs.empty() || stopping; });
+                    if (jobs.empty()) return;
+                    job = jobs.front();
+                    jobs.erase(jobs.begin());
+                }
+                int64_t result = job.write ? pwrite(job.fd, job.data, job.length, static_cast<off_t>(job.offset))
+                                           : fsync(job.fd);
+                if (result < 0) result = -errno;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done.push_back({job.tag, result});
+                }
+                uint64_t one = 1;
+                if (::write(kickFd, &one, sizeof(one)) < 0) {}
+            }
+        }
+    };
+
+    size_t bufferBytes = 64 * 1024;
+    size_t bufferCount = 16;
+    size_t queueLimit = 1024 * 1024;
+    std::unique_ptr<char[]> memory;
+    std::unique_ptr<Backend> backend;
+    int kickFd = -1;
+    bool running = false;
+    std::thread worker;
+
+    // Guarded by the mutex
+    std::mutex mutex;
+    std::condition_variable progress;             // ops finished
+    std::vector<File> files;
+    std::vector<int> freeBuffers;
+    std::vector<std::string> spare;               // emptied op strings, kept for their capacity
+    size_t queuedBytes = 0;
+    size_t queuedOps = 0;
+    size_t inFlight = 0;
+    size_t settling = 0;                          // truncates and closes not yet done
+    bool stopping = false;
+    bool kicked = false;
+    Stats stats;
+
+    // Writer thread only
+    std::vector<std::pair<int, uint64_t>> truncates;   // fd, length
+    std::vector<int> closes;
+
+    void kick() {
+        uint64_t one = 1;
+        if (::write(kickFd, &one, sizeof(one)) < 0) {}
+    }
+
+    void queue(int handle, Kind kind, std::initializer_list<std::string_view> parts, uint64_t offset) {
+        if (!running || handle < 0 || static_cast<size_t>(handle) >= MAX_FILES) return;
+        size_t bytes = 0;
+        for (std::string_view part : parts) bytes += part.size();
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            File& file = files[handle];
+            if (!file.used) return;
+            Op* last = file.ops.size() > file.head ? &file.ops.back() : nullptr;
+            if (last && last->started) last = nullptr;
+            if (kind == Kind::Replace) {
+                // The new content supersedes queued writes that have not started
+                while (file.ops.size() > file.head && !file.ops.back().started
+                       && file.ops.back().kind != Kind::Sync && file.ops.back().kind != Kind::Close) {
+                    dropLast(file);
+                }
+                last = nullptr;
+            }
+            if (kind == Kind::Append && last && last->kind == Kind::Append) {
+                for (std::string_view part : parts) last->data.append(part.data(), part.size());
+            } else {
+                pushOp(file, kind, offset);
+                Op& op = file.ops.back();
+                for (std::string_view part : parts) op.data.append(part.data(), part.size());
+                queuedOps++;
+            }
+            queuedBytes += bytes;
+            stats.maxQueuedBytes = std::max(stats.maxQueuedBytes, queuedBytes);
+            wake = !kicked;
+            kicked = true;
+        }
+        if (wake) kick();
+    }
+
+    void pushOp(File& file, Kind kind, uint64_t offset) {
+        if (file.head > 0 && file.ops.size() == file.ops.capacity()) {
+            file.ops.erase(file.ops.begin(), file.ops.begin() + file.head);
+            file.head = 0;
+        }
+        file.ops.emplace_back();
+        Op& op = file.ops.back();
+        op.kind = kind;
+        op.offset = offset;
+        if (!spare.empty()) {
+            op.data.swap(spare.back());
+            spare.pop_back();
+        }
+    }
+
+    void dropLast(File& file) {
+        Op& op = file.ops.back();
+        queuedBytes -= op.data.size();
+        queuedOps--;
+        recycle(op.data);
+        file.ops.pop_back();
+    }
+
+    void popHead(File& file) {
+        Op& op = file.ops[file.head];
+        queuedBytes -= op.data.size() - std::min(op.done, op.data.size());
+        queuedOps--;
+        recycle(op.data);
+        file.head++;
+        if (file.head == file.ops.size()) {
+            file.ops.clear();
+            file.head = 0;
+        }
+    }
+
+    void recycle(std::string& data) {
+        data.clear();
+        if (spare.size() < MAX_SPARE) {
+            spare.emplace_back();
+            spare.back().swap(data);
+        }
+    }
+
+    void run() {
+        std::vector<Request> requests;
+        std::vector<Completion> completed;
+        while (true) {
+            requests.clear();
+            bool done;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                kicked = false;
+                collect(requests);
+                done = stopping && queuedOps == 0 && inFlight == 0;
+            }
+            // Before the writes that follow them in their file
+            settle();
+            if (done) break;
+            backend->submit(requests);
+
+            completed.clear();
+            backend->wait(completed);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (const Completion& completion : completed) {
+                    finish(files[completion.tag], completion.result);
+                }
+            }
+            settle();
+            std::lock_guard<std::mutex> lock(mutex);
+            progress.notify_all();
+        }
+    }
+
+    // Truncates and closes that ops left to do, outside the lock since they
+    // may be slow on a network mount.
+    void settle() {
+        if (truncates.empty() && closes.empty()) return;
+        for (auto& [fd, length] : truncates) {
+            if (ftruncate(fd, static_cast<off_t>(length)) < 0) {}
+        }
+        for (int fd : closes) ::close(fd);
+        std::lock_guard<std::mutex> lock(mutex);
+        settling -= truncates.size() + closes.size();
+        truncates.clear();
+        closes.clear();
+        progress.notify_all();
+    }
+
+    // Starts the next op of every idle file. Ops that need no I/O of their
+    // own (close, an empty replace) finish here and leave their syscall to
+    // settle().
+    void collect(std::vector<Request>& requests) {
+        for (size_t index = 0; index < files.size(); index++) {
+            File& file = files[index];
+            while (file.used && !file.busy && file.ops.size() > file.head) {
+                Op& op = file.ops[file.head];
+                if (!op.started) {
+                    op.started = true;
+                    if (op.kind == Kind::Append) op.offset = file.end;
+                    if (op.kind == Kind::Replace) op.offset = 0;
+                }
+                if (op.kind == Kind::Close) {
+                    closes.push_back(file.fd);
+                    settling++;
+                    popHead(file);
+                    file = File();
+                    break;
+                }
+                if (op.kind == Kind::Replace && op.data.empty()) {
+                    truncates.emplace_back(file.fd, 0);
+                    settling++;
+                    file.end = 0;
+                    popHead(file);
+                    continue;
+                }
+                Request request = {index, file.fd, op.kind != Kind::Sync, -1, nullptr, 0, 0};
+                if (request.write) {
+                    if (freeBuffers.empty()) return;
+                    file.buffer = freeBuffers.back();
+                    freeBuffers.pop_back();
+                    file.length = std::min(bufferBytes, op.data.size() - op.done);
+                    request.buffer = file.buffer;
+                    request.data = memory.get() + static_cast<size_t>(file.buffer) * bufferBytes;
+                    request.length = file.length;
+                    request.offset = op.offset + op.done;
+                    memcpy(request.data, op.data.data() + op.done, file.length);
+                    stats.writes++;
+                } else {
+                    stats.syncs++;
+                }
+                file.busy = true;
+                file.since = std::chrono::steady_clock::now();
+                requests.push_back(request);
+                inFlight++;
+            }
+        }
+        if (!requests.empty()) {
+            stats.submissions++;
+            stats.maxInFlight = std::max(stats.maxInFlight, inFlight);
+        }
+    }
+
+    void finish(File& file, int64_t result) {
+        file.busy = false;
+        inFlight--;
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - file.since).count();
+        stats.maxMicros = std::max(stats.maxMicros, micros);
+        Op& op = file.ops[file.head];
+        if (file.buffer >= 0) {
+            freeBuffers.push_back(file.buffer);
+            file.buffer = -1;
+        }
+        if (result == -EINTR || result == -EAGAIN) return;   // retried next round
+        if (result < 0) {
+            if (stats.failures++ == 0) std::cerr << "⚠️ Writer: " << strerror(static_cast<int>(-result)) << std::endl;
+            popHead(file);
+            return;
+        }
+        if (op.kind == Kind::Sync) {
+            popHead(file);
+            return;
+        }
+        // Nothing written would be resubmitted forever and hang flush();
+        // only short writes that made progress are retried
+        if (result == 0 && op.done < op.data.size()) {
+            if (stats.failures++ == 0) std::cerr << "⚠️ Writer: write made no progress" << std::endl;
+            popHead(file);
+            return;
+        }
+        size_t written = static_cast<size_t>(result);
+        op.done += written;
+        queuedBytes -= written;
+        if (op.done < op.data.size()) return;            // short write: the rest goes next round
+        uint64_t end = op.offset + op.data.size();
+        if (op.kind == Kind::Replace) {
+            truncates.emplace_back(file.fd, end);
+            settling++;
+            file.end = end;
+        } else {
+            file.end = std::max(file.end, end);
+        }
+        popHead(file);
+    }
+};
@@ -2,24 +2,143 @@
 #include <cstdio>
 #include <string>
 #include <vector>
+#include <deque>
 #include <fstream>
 #include <signal.h>
+#include <unistd.h>
+#include <cstring>
 #include <ctime>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <charconv>
+#include <memory_resource>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/uio.h>
 #include "vosk-linux-x86_64-0.3.45/vosk_api.h"
+#include "recorder_settings.h"
+#include "async_writer.h"
+#include "archive_encoder.h"
+#include "preroll_ring.h"
+#include "resampler.h"
+#include "sample_span.h"
+#include "dsp_chain.h"
+#include "prefilter.h"
+#include "endpointer.h"
+#include "nbest.h"
+#include "rescorer.h"
+#include "punctuator.h"
+#include "capture_reader.h"
+#include "task_scheduler.h"
+#include "parallel_recognizer.h"
+#include "translator.h"
+#include "transcript_index.h"
+#include "transcription_server.h"
+#include "control_channel.h"
+#include "wer.h"
+#include "utterance_arena.h"
+#include "text_updates.h"
+#include "event_loop.h"
+#include "partial_stabilizer.h"
+#include "stop_deadline.h"
+
+// Counts every heap allocation per thread (see AllocationCounter). Array,
+// sized and nothrow forms fall back to these. Kept out of line so GCC does
+// not pair the malloc/free inside them with new/delete at call sites.
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    AllocationCounter::allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// Server-mode exit trigger. A plain flag so the handler stays
+// async-signal-safe; the server loop checks it between polls. Recording and
+// the daemon take their signals through the event loop instead.
+namespace serverSignals {
+    volatile sig_atomic_t quit = 0;
+    
+    void install() {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = [](int) { quit = 1; };
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+    }
+}
 
 class AudioRecorder {
 private:
-    bool running = true;
-    std::vector<int16_t> audioData;
+    RecorderSettings settings;
+    AsyncWriter writer;                   // before its users, so it outlives them
+    int textFile = -1;                    // writer handles of the status files
+    int updatesFile = -1;
+    int translatedFile = -1;
+    int levelFile = -1;
+    ArchiveEncoder archive;
+    bool archiving = false;
+    size_t totalBytes = 0;
+    double levelSum = 0.0;                // |sample| since the level timer last fired
+    size_t levelSamples = 0;
+    int audioLevel = 0;                   // 0-10, as last published
+    time_t startTime = 0;
+    int modelSampleRate = 16000;
+    int captureRate = 16000;
+    int captureChannels = 1;
+    CaptureConverter converter;
+    AlignedBuffer<int16_t> captureBuffer;
+    CaptureReader capture;
+    volatile float benchmarkSink = 0;
+    Prefilter prefilter;
+    DspChain dsp;
+    Endpointer endpointer;
+    UtteranceArena arena;                 // strings that live until the utterance's final
+    std::pmr::string heldText{&arena};    // model finals merged into the current utterance
+    uint64_t recognizerAllocations = 0;   // heap allocations inside Vosk on the recording thread
+    uint64_t sessionAllocations = 0;      // AllocationCounter::allocations at beginSession
+    RescoreWorker::Utterance heldSegments; // their N-best lists, one per model final
+    std::vector<Hypothesis> hypotheses;   // parse scratch
+    RescoreWorker rescoring;
+    PunctuationWorker punctuation;
+    TaskScheduler scheduler;              // before its users, so it outlives them
+    ParallelRecognition parallel;
+    TranslationWorker translation;
+    TranscriptIndexer history;
+    struct PendingFinal {
+        StreamRange range;
+        uint64_t segment = 0;
+    };
+    std::deque<PendingFinal> pendingFinals;    // one per utterance on its way to writeFinalText
+    TextUpdateStream updates;
+    PartialStabilizer stabilizer;
+    uint64_t segment = 0;                      // text-update segment of the current utterance
+    ControlChannel control;
     VoskModel *model = nullptr;
     VoskRecognizer *rec = nullptr;
     std::string accumulatedText = "";
+    std::string accumulatedTranslation;
     
     const std::string MODEL_PATH = "/home/kaplan/Documents/vosk-model-small-en-us-0.15";  // Default fallback
     const std::string OUTPUT_TEXT_FILE = "recognized_text.txt";
+    const std::string TEXT_UPDATES_FILE = "text_updates.txt";
+    const std::string TRANSLATED_TEXT_FILE = "translated_text.txt";
     const std::string AUDIO_LEVEL_FILE = "audio_level.txt";
     const std::string MODEL_CONFIG_FILE = "current_model.txt";
+    const std::string SETTINGS_FILE = "recorder_settings.txt";
+    const std::string CONTROL_SOCKET = "control.sock";
 
 public:
     AudioRecorder() = default;
@@ -28,6 +147,20 @@ public:
         cleanup();
     }
     
+    void loadSettings() {
+        settings.load(SETTINGS_FILE);
+    }
+    
+    // "key=value" from the command line, applied on top of the settings file
+    bool overrideSetting(const std::string& assignment) {
+        size_t eq = assignment.find('=');
+        if (eq == std::string::npos || !settings.apply(assignment.substr(0, eq), assignment.substr(eq + 1))) {
+            std::cerr << "⚠️ Ignoring setting: " << assignment << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
     bool initialize() {
         vosk_set_log_level(-1);
         
@@ -45,6 +178,7 @@ public:
             if (modelPath != MODEL_PATH) {
                 std::cerr << "🔄 Trying default model path..." << std::endl;
                 model = vosk_model_new(MODEL_PATH.c_str());
+                modelPath = MODEL_PATH;
             }
             
             if (!model) {
@@ -55,7 +189,8 @@ public:
         
         std::cout << "✅ Vosk model loaded: " << modelPath << std::endl;
         
-        rec = vosk_recognizer_new(model, 16000.0);
+        modelSampleRate = readModelSampleRate(modelPath);
+        rec = vosk_recognizer_new(model, static_cast<float>(modelSampleRate));
         if (!rec) {
             std::cerr << "❌ Vosk recognizer could not be created!" << std::endl;
             vosk_model_free(model);
@@ -78,22 +213,36 @@ public:
     }
     
     void clearFiles() {
+        startWriter();
         accumulatedText = "";
-        writeToFile(OUTPUT_TEXT_FILE, "");
-        writeToFile(AUDIO_LEVEL_FILE, "0");
+        accumulatedTranslation.clear();
+        writer.replace(textFile, "\n");
+        updates.open(writer, updatesFile);
+        segment = 0;
+        writer.replace(translatedFile, "\n");
+        writer.replace(levelFile, "0\n");
     }
     
-    void writeToFile(const std::string& filename, const std::string& content) {
-        std::ofstream file(filename, std::ios::out | std::ios::trunc);
-        if (file.is_open()) {
-            file << content << std::endl;
-            file.close();
-        }
+    // Session output is written by the async writer, never on the recording
+    // thread. The status files stay open for the life of the process and
+    // are rewritten in place.
+    void startWriter() {
+        if (writer.active()) return;
+        writer.start(settings);
+        textFile = writer.open(OUTPUT_TEXT_FILE, true);
+        updatesFile = writer.open(TEXT_UPDATES_FILE, true);
+        translatedFile = writer.open(TRANSLATED_TEXT_FILE, true);
+        levelFile = writer.open(AUDIO_LEVEL_FILE, true);
     }
     
-    void writePartialText(const std::string& text) {
-        if (text.empty()) return;
-        writeToFile(OUTPUT_TEXT_FILE, text);
+    // Plain open/writev/close for one-off files (the model path); an
+    // ofstream allocates its buffer on every call.
+    void writeToFile(const std::string& filename, std::string_view content) {
+        int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return;
+        iovec parts[2] = {{const_cast<char*>(content.data()), content.size()}, {const_cast<char*>("\n"), 1}};
+        if (writev(fd, parts, 2) < 0) {}
+        ::close(fd);
     }
     
     void writeRecognizedText(const std::string& text) {
@@ -103,11 +252,23 @@ public:
             accumulatedText += " ";
         }
         accumulatedText += text;
-        writeToFile(OUTPUT_TEXT_FILE, accumulatedText);
+        writer.replace(textFile, {accumulatedText, "\n"});
+    }
+    
+    void writeTranslatedText(const std::string& text) {
+        if (text.empty()) return;
+        
+        if (!accumulatedTranslation.empty()) {
+            accumulatedTranslation += " ";
+        }
+        accumulatedTranslation += text;
+        writer.replace(translatedFile, {accumulatedTranslation, "\n"});
     }
     
     void writeAudioLevel(int level) {
-        writeToFile(AUDIO_LEVEL_FILE, std::to_string(level));
+        char text[16];
+        char* end = std::to_chars(text, text + sizeof(text), level).ptr;
+        writer.replace(levelFile, {std::string_view(text, end - text), "\n"});
     }
     
     std::string readCurrentModelPath() {
@@ -129,37 +290,81 @@ public:
         return "";  // Return empty string if no valid path found
     }
     
+    // Feature extraction rate from the model's conf/mfcc.conf
+    // (16000 for the usual models, 8000 for telephony ones).
+    int readModelSampleRate(const std::string& modelPath) {
+        std::ifstream mfccFile(modelPath + "/conf/mfcc.conf");
+        std::string line;
+        const std::string key = "--sample-frequency=";
+        while (std::getline(mfccFile, line)) {
+            if (line.compare(0, key.size(), key) == 0) {
+                int rate = std::atoi(line.c_str() + key.size());
+                if (rate > 0) return rate;
+            }
+        }
+        return 16000;
+    }
+    
     void writeCurrentModelPath(const std::string& modelPath) {
         writeToFile(MODEL_CONFIG_FILE, modelPath);
     }
     
-    std::string extractTextFromJson(const std::string& jsonStr) {
-        size_t textPos = jsonStr.find("\"text\"");
-        if (textPos == std::string::npos) return "";
+    // View of the "text" (or `key`) value inside `jsonStr`; valid as long
+    // as it is.
+    std::string_view extractTextFromJson(std::string_view jsonStr, std::string_view key = "\"text\"") {
+        size_t textPos = jsonStr.find(key);
+        if (textPos == std::string_view::npos) return {};
         
         size_t colonPos = jsonStr.find(":", textPos);
-        if (colonPos == std::string::npos) return "";
+        if (colonPos == std::string_view::npos) return {};
         
         size_t startQuote = jsonStr.find("\"", colonPos);
-        if (startQuote == std::string::npos) return "";
+        if (startQuote == std::string_view::npos) return {};
         
         size_t endQuote = jsonStr.find("\"", startQuote + 1);
-        if (endQuote == std::string::npos) return "";
+        if (endQuote == std::string_view::npos) return {};
         
         return jsonStr.substr(startQuote + 1, endQuote - startQuote - 1);
     }
     
-    int calculateAudioLevel(int16_t* samples, size_t sampleCount) {
-        if (sampleCount == 0) return 0;
+    std::string getDefaultSource() {
+        FILE* pipe = popen("pactl info | grep 'Default Source' | cut -d' ' -f3", "r");
+        if (!pipe) return "";
         
-        int32_t sum = 0;
-        for (size_t i = 0; i < sampleCount; i++) {
-            sum += abs(samples[i]);
+        char buffer[256];
+        std::string result = "";
+        if (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+            result = std::string(buffer);
+            if (!result.empty() && result.back() == '\n') {
+                result.pop_back();
+            }
         }
+        pclose(pipe);
+        return result;
+    }
+    
+    // Native sample spec of a source from `pactl list short sources`,
+    // e.g. "alsa_input.pci-0000_00_1f.3.analog-stereo  ...  s16le 2ch 48000Hz".
+    bool getSourceFormat(const std::string& source, int& rate, int& channels) {
+        FILE* pipe = popen("pactl list short sources", "r");
+        if (!pipe) return false;
         
-        double avgLevel = (double)sum / sampleCount;
-        int level = (int)(avgLevel / 3276.7);  // 32767 / 10
-        return (level > 10) ? 10 : level;
+        char buffer[512];
+        bool found = false;
+        while (!found && fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+            char name[256];
+            char spec[64];
+            int parsedChannels = 0;
+            int parsedRate = 0;
+            if (sscanf(buffer, "%*s %255s %*s %63s %dch %dHz", name, spec, &parsedChannels, &parsedRate) == 4 &&
+                source == name && parsedChannels > 0 && parsedRate > 0) {
+                channels = parsedChannels;
+                rate = parsedRate;
+                found = true;
+            }
+        }
+        pclose(pipe);
+        return found;
     }
     
     std::string getSystemAudioMonitor() {
@@ -179,77 +384,452 @@ public:
         return result;
     }
     
-    void saveWAVFile(const std::string& filename) {
-        struct WAVHeader {
-            char chunkID[4] = {'R', 'I', 'F', 'F'};
-            uint32_t chunkSize;
-            char format[4] = {'W', 'A', 'V', 'E'};
-            char subchunk1ID[4] = {'f', 'm', 't', ' '};
-            uint32_t subchunk1Size = 16;
-            uint16_t audioFormat = 1;
-            uint16_t numChannels = 1;
-            uint32_t sampleRate = 16000;
-            uint32_t byteRate = 32000;
-            uint16_t blockAlign = 2;
-            uint16_t bitsPerSample = 16;
-            char subchunk2ID[4] = {'d', 'a', 't', 'a'};
-            uint32_t subchunk2Size;
-        };
-        
-        std::ofstream file(filename, std::ios::binary);
-        if (!file) {
-            std::cerr << "❌ Could not create WAV file: " << filename << std::endl;
-            return;
+    bool buildCaptureCommand(int mode, std::string& command, std::string& sourceType, std::string& outputPrefix) {
+        std::string device;
+        if (mode == 1) {
+            sourceType = "Mikrofon";
+            outputPrefix = "mikrofon_";
+        } else if (mode == 2) {
+            device = getSystemAudioMonitor();
+            if (device.empty()) {
+                std::cerr << "❌ System audio monitor not found!" << std::endl;
+                return false;
+            }
+            sourceType = "System audio";
+            outputPrefix = "sistem_sesi_";
+        } else {
+            std::cerr << "❌ Invalid recording mode!" << std::endl;
+            return false;
         }
         
-        WAVHeader header;
-        header.subchunk2Size = audioData.size() * sizeof(int16_t);
-        header.chunkSize = 36 + header.subchunk2Size;
+        // Capture in the device's own rate/channel layout and convert here, so
+        // the server does not resample on our behalf. Falls back to asking the
+        // server for the model format if the spec cannot be read.
+        captureRate = modelSampleRate;
+        captureChannels = 1;
+        if (settings.captureNative) {
+            std::string source = device.empty() ? getDefaultSource() : device;
+            if (!getSourceFormat(source, captureRate, captureChannels)) {
+                captureRate = modelSampleRate;
+                captureChannels = 1;
+            }
+        }
+        size_t chunkFrames = captureRate / 100;
+        converter.configure(captureRate, captureChannels, modelSampleRate, settings.resamplerTaps, chunkFrames);
+        captureBuffer.allocate(chunkFrames * captureChannels);
+        prefilter.configure(settings, mode, modelSampleRate, chunkFrames);
         
-        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
-        file.write(reinterpret_cast<const char*>(audioData.data()), header.subchunk2Size);
-        file.close();
+        command = "parec --format=s16le --rate=" + std::to_string(captureRate) +
+                  " --channels=" + std::to_string(captureChannels) + " --latency-msec=50";
+        if (!device.empty()) {
+            command += " --device=" + device;
+        }
+        if (!converter.passthrough()) {
+            std::cout << "🔁 Converting " << captureRate << "Hz/" << captureChannels << "ch -> "
+                      << modelSampleRate << "Hz mono" << std::endl;
+        }
+        return true;
+    }
+    
+    // Starts the capture thread on the parec pipe and moves the calling
+    // (recording) thread onto the decode cores.
+    void startCapture(FILE* pipe) {
+        capture.start(pipe, captureBuffer.capacity(), captureChannels, captureRate, settings);
+        std::vector<int> cpus = CaptureReader::decodeCpus(settings);
+        if (!threadPolicy::setAffinity(cpus)) {
+            std::cerr << "⚠️ Could not move decode to cpus " << threadPolicy::describe(cpus) << std::endl;
+        }
     }
     
-    void setSignalHandler() {
-        signal(SIGINT, [](int signal) {
-            static AudioRecorder* instance = nullptr;
-            if (instance) {
-                instance->running = false;
+    // Runs `onChunk` on every captured chunk (as a span at the model rate,
+    // see withCaptureSpan) and control commands as they arrive. At most 8
+    // chunks are taken per wakeup, so a backlog does not hold off signals
+    // and timers; the loop stops when the capture stream ends.
+    template <typename OnChunk>
+    void watchCapture(EventLoop& loop, OnChunk onChunk) {
+        loop.watch(capture.readyFd(), [this, &loop, onChunk] {
+            bool ended = false;
+            for (int taken = 0; taken < 8; taken++) {
+                size_t samples = capture.tryRead(captureBuffer.data(), ended);
+                if (samples == 0) break;
+                withCaptureSpan(samples / captureChannels, onChunk);
             }
+            if (ended) loop.stop();
         });
-        signal(SIGTERM, [](int signal) {
-            static AudioRecorder* instance = nullptr;
-            if (instance) {
-                instance->running = false;
+        loop.watch(control.fd(), [this] { pollControl(); });
+    }
+    
+    // Decodes the blocks still queued when a stop is requested, so the last
+    // words spoken reach the final result. Blocks left once half the stop
+    // deadline is used up are dropped.
+    void drainCapture(StopDeadline& stopping) {
+        stopping.phase("drain");
+        size_t blocks = 0;
+        size_t dropped = 0;
+        bool ended = false;
+        while (size_t samples = capture.tryRead(captureBuffer.data(), ended)) {
+            if (!stopping.withinBudget()) {
+                dropped++;
+                continue;
             }
-        });
+            withCaptureSpan(samples / captureChannels, [this](auto span) { processChunk(span); });
+            blocks++;
+        }
+        stopping.drained(blocks, dropped);
     }
     
-    bool record(int mode) {
-        std::string command;
-        std::string sourceType;
-        std::string outputFilename;
-        
+    // Hands the last read to `fn` as a mono span at the model rate: the capture
+    // buffer itself (int16) when the format already matches, otherwise the
+    // converter's float output. No per-sample copies either way, except that
+    // an enabled prefilter widens int16 capture into its own float buffer.
+    template <typename Fn>
+    void withCaptureSpan(size_t frames, Fn&& fn) {
+        if (converter.passthrough()) {
+            Int16Span samples = captureBuffer.span(frames);
+            if (prefilter.active()) {
+                fn(prefilter.process(samples));
+            } else {
+                fn(samples);
+            }
+        } else {
+            FloatSpan samples = converter.process(captureBuffer.data(), frames);
+            fn(prefilter.active() ? prefilter.process(samples) : samples);
+        }
+    }
+    
+    static int acceptWaveform(VoskRecognizer* recognizer, Int16Span samples) {
+        return vosk_recognizer_accept_waveform_s(recognizer, samples.data, static_cast<int>(samples.size));
+    }
+    
+    static int acceptWaveform(VoskRecognizer* recognizer, FloatSpan samples) {
+        return vosk_recognizer_accept_waveform_f(recognizer, samples.data, static_cast<int>(samples.size));
+    }
+    
+    void beginSession(const std::string& outputPrefix) {
         time_t now = time(0);
         char timestamp[100];
         strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S", localtime(&now));
         
-        if (mode == 1) {
-            command = "parec --format=s16le --rate=16000 --channels=1 --latency-msec=50";
-            sourceType = "Mikrofon";
-            outputFilename = std::string("mikrofon_") + timestamp + ".wav";
-        } else if (mode == 2) {
-            std::string monitor = getSystemAudioMonitor();
-            if (monitor.empty()) {
-                std::cerr << "❌ System audio monitor not found!" << std::endl;
-                return false;
+        // Archive is compressed incrementally on a worker thread
+        startWriter();
+        archiving = archive.start(outputPrefix + timestamp, settings, modelSampleRate, writer);
+        dsp.configure(settings, modelSampleRate);
+        endpointer.configure(settings, modelSampleRate);
+        stabilizer.configure(settings);
+        resetUtterance();
+        heldSegments.clear();
+        if (rec) {
+            vosk_recognizer_set_max_alternatives(rec, settings.alternatives);
+        }
+        rescoring.start(RescoreWorker::create(settings, model));
+        if (settings.punctuation) {
+            punctuation.start(settings.punctuationDeadlineMs, settings.punctuationBatch);
+        }
+        if (!settings.parallelModel.empty()) {
+            parallel.start(settings, model, modelSampleRate, decodeScheduler());
+        }
+        pendingFinals.clear();
+        if (settings.transcriptIndex) {
+            history.start(settings.transcriptDir, archiving ? archive.path() : "", modelSampleRate,
+                          settings.indexFlushSegments);
+        }
+        if (settings.translation) {
+            translation.start(TranslationWorker::create(settings), settings.translationBatch,
+                              settings.translationCache, settings.translationTarget);
+        }
+        totalBytes = 0;
+        levelSum = 0.0;
+        levelSamples = 0;
+        startTime = time(nullptr);
+        recognizerAllocations = 0;
+        arena.takeHighWater();
+        sessionAllocations = AllocationCounter::allocations;
+    }
+    
+    // Archive gets the capture after the prefilter, before noise suppression
+    // and AGC; the recognizer gets the DSP chain output when any stage is
+    // enabled.
+    template <typename T>
+    void processChunk(SampleSpan<T> samples) {
+        totalBytes += samples.size * sizeof(int16_t);
+        archive.push(samples.data, samples.size);
+        
+        if (dsp.active()) {
+            feedRecognizer(dsp.process(samples));
+        } else {
+            feedRecognizer(samples);
+        }
+    }
+    
+    template <typename T>
+    void feedRecognizer(SampleSpan<T> samples) {
+        // Immediate speech recognition processing
+        if (rec) {
+            rescoring.poll([this](const std::string& text) { emitText(text); });
+            punctuation.poll([this](const std::string& text, const std::string& language) {
+                writeFinalText(text, language);
+            });
+            translation.poll([this](const std::string& text) { writeTranslatedText(text); });
+            
+            if (parallel.running()) {
+                parallel.feed(samples);
+                parallel.poll([this](const std::string& text, const std::string& language, StreamRange range) {
+                    emitText(text, language, range);
+                });
+                return;
+            }
+            
+            // Always get partial result for real-time updates, sent as an
+            // edit of the previous one. The display text only lives for
+            // this chunk.
+            {
+                UtteranceArena::Scope chunkScratch(arena);
+                const char* partialResult = recognizer([&] { return vosk_recognizer_partial_result(rec); });
+                std::string_view partialText = extractTextFromJson(partialResult, "\"partial\"");
+                if (!partialText.empty() || !heldText.empty()) {
+                    std::pmr::string display(&arena);
+                    display.reserve(heldText.size() + 1 + partialText.size());
+                    display += heldText;
+                    if (!heldText.empty() && !partialText.empty()) display += ' ';
+                    display += partialText;
+                    size_t stableBytes = 0;
+                    std::string_view shown = stabilizer.update(display, heldText.size(), streamMs(), stableBytes);
+                    updates.partial(segment, shown, stableBytes);
+                }
+            }
+            
+            // Check for final result
+            bool modelFinal = recognizer([&] { return acceptWaveform(rec, samples); });
+            endpointer.update(samples);
+            if (modelFinal) {
+                bool held = holdResult(recognizer([&] { return vosk_recognizer_result(rec); }));
+                if (!endpointer.holdsModelFinals()) {
+                    emitUtterance(Endpointer::Reason::Model);
+                    return;
+                }
+                if (held) endpointer.modelFinal();
+            }
+            
+            Endpointer::Reason reason = endpointer.check();
+            if (reason != Endpointer::Reason::None) {
+                holdResult(recognizer([&] { return vosk_recognizer_final_result(rec); }));
+                emitUtterance(reason);
+            }
+        }
+    }
+    
+    // Audio fed to the recognizer this session, in ms.
+    double streamMs() const {
+        return static_cast<double>(totalBytes) / sizeof(int16_t) * 1000.0 / modelSampleRate;
+    }
+    
+    // Runs a Vosk call on the recording thread; what it allocates is counted
+    // apart from the pipeline's own allocations.
+    template <typename Call>
+    auto recognizer(Call&& call) {
+        AllocationCounter::Exclude vosk(recognizerAllocations);
+        return call();
+    }
+    
+    // Adds one recognizer result (plain or N-best) to the current utterance;
+    // false when it was empty
+    bool holdResult(const char* json) {
+        size_t count = ResultParser::parse(json, hypotheses);
+        if (count == 0) return false;
+        if (!heldText.empty()) heldText += ' ';
+        heldText += hypotheses[0].text;
+        if (rescoring.active()) {
+            heldSegments.emplace_back(hypotheses.begin(), hypotheses.begin() + count);
+        }
+        return true;
+    }
+    
+    // Finalizes the held utterance: straight out with the top hypotheses, or
+    // via the rescoring worker, whose pick is emitted on a later chunk.
+    void emitUtterance(Endpointer::Reason reason) {
+        if (!heldText.empty()) {
+            pendingFinals.push_back({endpointer.utteranceRange(), segment});
+            if (rescoring.active()) {
+                rescoring.submit(std::move(heldSegments));
+                heldSegments.clear();
+            } else {
+                emitText(std::string(heldText));
             }
-            command = "parec --format=s16le --rate=16000 --channels=1 --latency-msec=50 --device=" + monitor;
-            sourceType = "System audio";
-            outputFilename = std::string("sistem_sesi_") + timestamp + ".wav";
         } else {
-            std::cerr << "❌ Invalid recording mode!" << std::endl;
+            updates.finalize(segment, "");   // clears partials that came to nothing
+        }
+        segment++;
+        stabilizer.reset();
+        resetUtterance();
+        endpointer.finalized(reason);
+    }
+    
+    // Drops the utterance's strings and rewinds the arena under them.
+    // Swapped rather than assigned: assigning an empty string keeps the old
+    // buffer, which would then point into rewound memory.
+    void resetUtterance() {
+        std::pmr::string(&arena).swap(heldText);
+        arena.reset();
+    }
+    
+    // Chosen text of a finished utterance; punctuated in the background
+    // when enabled.
+    void emitText(const std::string& text) {
+        emitText(text, settings.textLanguage);
+    }
+    
+    void emitText(const std::string& text, const std::string& language, StreamRange range) {
+        pendingFinals.push_back({range, segment++});
+        emitText(text, language);
+    }
+    
+    void emitText(const std::string& text, const std::string& language) {
+        if (punctuation.active()) {
+            punctuation.submit(text, language);
+        } else {
+            writeFinalText(text, language);
+        }
+    }
+    
+    // Final text as shown to the user; also queued for translation and the
+    // transcript index. Every utterance arrives here exactly once and in
+    // order, so its stream range and segment are the oldest ones queued.
+    void writeFinalText(const std::string& text, const std::string& language) {
+        PendingFinal pending;
+        if (!pendingFinals.empty()) {
+            pending = pendingFinals.front();
+            pendingFinals.pop_front();
+            updates.finalize(pending.segment, text);
+        }
+        StreamRange range = pending.range;
+        if (text.empty()) return;
+        if (history.active()) {
+            history.submit(range, language, text);
+        }
+        std::cout << "\n🔊 " << text << std::endl;
+        writeRecognizedText(text);
+        if (translation.active()) {
+            translation.submit(text, language);
+        }
+    }
+    
+    // Adds a chunk to the audio level the level timer publishes next.
+    template <typename T>
+    void trackLevel(SampleSpan<T> samples) {
+        for (T sample : samples) {
+            levelSum += std::abs(sample);
+        }
+        levelSamples += samples.size;
+    }
+    
+    // Level timer: mean level since the last tick, for the panel icon
+    void publishLevel() {
+        if (levelSamples == 0) return;
+        int level = static_cast<int>(levelSum / levelSamples / 3276.7);  // 32767 / 10
+        audioLevel = level > 10 ? 10 : level;
+        levelSum = 0.0;
+        levelSamples = 0;
+        writeAudioLevel(audioLevel);
+    }
+    
+    // Status timer: elapsed time, level bar and size on the console
+    void printStatus() {
+        int elapsedSeconds = time(nullptr) - startTime;
+        std::cout << "\r🔴 " << elapsedSeconds << "s [";
+        for (int i = 0; i < 10; i++) {
+            std::cout << (i < audioLevel ? "=" : " ");
+        }
+        std::cout << "] " << (totalBytes/1024) << "KB" << std::flush;
+    }
+    
+    // Periodic work while recording, on the loop's timers
+    void watchTimers(EventLoop& loop, const bool& recording) {
+        loop.every(80, [this, &recording] { if (recording) publishLevel(); });
+        loop.every(1000, [this, &recording] { if (recording) printStatus(); });
+    }
+    
+    void endSession() {
+        StopDeadline unbounded;
+        endSession(unbounded);
+    }
+    
+    // Shutdown order: final result, then the transcript (rescoring and
+    // punctuation finish what they hold), then the slower sinks, so the
+    // last words are written first and a stop deadline can only cut short
+    // translation, the index or the archive.
+    void endSession(StopDeadline& stopping) {
+        reportAllocations();
+        
+        // Final recognition
+        if (rec) {
+            stopping.phase("final result");
+            if (parallel.running()) {
+                parallel.finish([this](const std::string& text, const std::string& language, StreamRange range) {
+                    emitText(text, language, range);
+                });
+            } else {
+                holdResult(recognizer([&] { return vosk_recognizer_final_result(rec); }));
+                emitUtterance(Endpointer::Reason::SessionEnd);
+            }
+            stopping.phase("transcript");
+            rescoring.stop();
+            rescoring.poll([this](const std::string& text) { emitText(text); });
+            rescoring.report();
+            punctuation.stop();
+            punctuation.poll([this](const std::string& text, const std::string& language) {
+                writeFinalText(text, language);
+            });
+            punctuation.report();
+            writer.flush();
+            stopping.textWritten();
+            stopping.phase("translation");
+            translation.stop();
+            translation.poll([this](const std::string& text) { writeTranslatedText(text); });
+            translation.report();
+            stopping.phase("index");
+            history.stop();
+            history.report();
+            endpointer.report();
+        }
+        
+        // Flush the archive encoder
+        if (archiving) {
+            stopping.phase("archive");
+            std::cout << "\n💾 Saving: " << archive.path() << std::endl;
+            archive.finish();
+            archiving = false;
+            std::cout << "✅ Completed!" << std::endl;
+        }
+        stopping.phase("flush");
+        writer.flush();
+        
+        stopping.finish();
+        writer.report();
+        updates.report();
+        stabilizer.report();
+        dsp.report();
+        capture.report();
+        stopping.report();
+        writeAudioLevel(0);
+    }
+    
+    // Heap allocations the recording thread made since beginSession, per
+    // second of audio, with Vosk's own counted apart.
+    void reportAllocations() {
+        double audioSeconds = static_cast<double>(totalBytes) / sizeof(int16_t) / modelSampleRate;
+        if (audioSeconds <= 0.0) return;
+        uint64_t own = AllocationCounter::allocations - sessionAllocations;
+        std::cout << "\n🧮 Recording thread: " << (own / audioSeconds) << " heap allocations per audio second ("
+                  << own << " in total), " << (recognizerAllocations / audioSeconds) << " per second inside Vosk; arena "
+                  << arena.capacity() / 1024 << " KB in " << arena.blockCount() << " blocks, peak "
+                  << arena.takeHighWater() / 1024.0 << " KB" << std::endl;
+    }
+    
+    bool record(int mode) {
+        std::string command;
+        std::string sourceType;
+        std::string outputPrefix;
+        if (!buildCaptureCommand(mode, command, sourceType, outputPrefix)) {
             return false;
         }
         
@@ -262,103 +842,754 @@ public:
             return false;
         }
         
-        char buffer[320];   // 0.02 second buffer - ultra-fast response
-        size_t totalBytes = 0;
-        time_t startTime = time(nullptr);
-        int updateCounter = 0;
-        std::vector<int16_t> chunkBuffer;
-        chunkBuffer.reserve(800); // Pre-allocate for better performance
+        // Signals are taken by the loop; blocked before capture and the
+        // encoder start (the writer already has them blocked, see main()).
+        // The stop deadline runs from the signal.
+        EventLoop loop;
+        StopDeadline stopping;
+        loop.watchSignals({SIGINT, SIGTERM}, [&](int) {
+            stopping.start(settings.stopDeadlineMs, true);
+            loop.stop();
+        });
+        startCapture(pipe);
+        control.open(CONTROL_SOCKET);
+        beginSession(outputPrefix);
         
-        while (running) {
-            size_t bytesRead = fread(buffer, 1, sizeof(buffer), pipe);
-            if (bytesRead == 0) break;
-            
-            if (bytesRead % 2 != 0) {
-                bytesRead--;
+        const bool recording = true;
+        watchCapture(loop, [this](auto samples) {
+            trackLevel(samples);
+            processChunk(samples);
+        });
+        watchTimers(loop, recording);
+        loop.run();
+        
+        // Also when capture ended on its own
+        stopping.start(settings.stopDeadlineMs, true);
+        stopping.phase("capture");
+        capture.stop();
+        pclose(pipe);
+        drainCapture(stopping);
+        endSession(stopping);
+        return true;
+    }
+    
+    void pollControl() {
+        control.poll([this](const std::string& line) { return handleControl(line); });
+    }
+    
+    // Control commands:
+    //   set <key> <value>   same keys as recorder_settings.txt, applied live
+    //   metrics             one line of DSP state (AGC gain trajectory etc.)
+    std::string handleControl(const std::string& line) {
+        std::istringstream command(line);
+        std::string verb, key, value;
+        command >> verb >> key;
+        std::getline(command >> std::ws, value);
+        
+        if (verb == "set") {
+            if (!settings.apply(key, value)) {
+                return "error: invalid setting " + key;
             }
+            prefilter.applySettings(settings);
+            dsp.applySettings(settings);
+            endpointer.applySettings(settings);
+            return "ok";
+        }
+        if (verb == "metrics") {
+            return dsp.metrics() + " " + writer.metrics();
+        }
+        return "error: unknown command " + verb;
+    }
+    
+    static bool readWAVFile(const std::string& filename, std::vector<int16_t>& samples, int& rate, int& channels) {
+        std::ifstream file(filename, std::ios::binary);
+        char riff[12];
+        if (!file.read(riff, sizeof(riff)) || std::string(riff, 4) != "RIFF" || std::string(riff + 8, 4) != "WAVE") {
+            return false;
+        }
+        
+        uint16_t bits = 0;
+        char chunkId[4];
+        uint32_t chunkSize;
+        while (file.read(chunkId, 4) && file.read(reinterpret_cast<char*>(&chunkSize), 4)) {
+            std::string id(chunkId, 4);
+            if (id == "fmt ") {
+                uint16_t format, numChannels;
+                uint32_t sampleRate;
+                std::vector<char> fmt(chunkSize);
+                file.read(fmt.data(), chunkSize);
+                memcpy(&format, &fmt[0], 2);
+                memcpy(&numChannels, &fmt[2], 2);
+                memcpy(&sampleRate, &fmt[4], 4);
+                memcpy(&bits, &fmt[14], 2);
+                if (format != 1 || bits != 16) return false;
+                channels = numChannels;
+                rate = static_cast<int>(sampleRate);
+            } else if (id == "data" && bits == 16) {
+                samples.resize(chunkSize / sizeof(int16_t));
+                file.read(reinterpret_cast<char*>(samples.data()), samples.size() * sizeof(int16_t));
+                return true;
+            } else {
+                file.seekg(chunkSize + (chunkSize & 1), std::ios::cur);
+            }
+        }
+        return false;
+    }
+    
+    // Offline A/B run over a 16-bit WAV file: decodes it once per pipeline
+    // variant and reports decode time, partial-result churn and, when a
+    // reference transcript is given, WER.
+    bool runEvaluation(const std::string& wavPath, const std::string& referencePath) {
+        if (!model) {
+            std::cerr << "❌ Evaluation needs a loaded model" << std::endl;
+            return false;
+        }
+        
+        std::vector<int16_t> pcm;
+        int rate = 0, channels = 0;
+        if (!readWAVFile(wavPath, pcm, rate, channels)) {
+            std::cerr << "❌ Could not read 16-bit PCM WAV: " << wavPath << std::endl;
+            return false;
+        }
+        
+        std::string reference;
+        if (!referencePath.empty()) {
+            std::ifstream referenceFile(referencePath);
+            std::getline(referenceFile, reference, '\0');
+        }
+        
+        CaptureConverter evalConverter;
+        size_t chunkFrames = rate / 100;
+        evalConverter.configure(rate, channels, modelSampleRate, settings.resamplerTaps, chunkFrames);
+        std::vector<float> audio;
+        for (size_t offset = 0; offset + chunkFrames * channels <= pcm.size(); offset += chunkFrames * channels) {
+            FloatSpan converted = evalConverter.process(&pcm[offset], chunkFrames);
+            audio.insert(audio.end(), converted.begin(), converted.end());
+        }
+        double audioSeconds = static_cast<double>(audio.size()) / modelSampleRate;
+        
+        struct Variant {
+            std::string name;
+            RecorderSettings settings;
+        };
+        std::vector<Variant> variants;
+        variants.push_back({"baseline", settings});
+        variants.back().settings.noiseReduction = false;
+        variants.push_back({"noise-reduction", settings});
+        variants.back().settings.noiseReduction = true;
+        
+        std::cout << "📊 Evaluating " << wavPath << " (" << audioSeconds << "s)" << std::endl;
+        for (Variant& variant : variants) {
+            DspChain chain;
+            chain.configure(variant.settings, modelSampleRate);
+            VoskRecognizer* evalRec = vosk_recognizer_new(model, static_cast<float>(modelSampleRate));
+            if (!evalRec) return false;
             
-            totalBytes += bytesRead;
-            int16_t* samples = (int16_t*)buffer;
-            size_t sampleCount = bytesRead / 2;
+            std::string transcript;
+            std::string lastPartial;
+            int partialUpdates = 0;
+            const size_t chunk = modelSampleRate / 100;
+            std::vector<float> block(chunk);
+            auto begin = std::chrono::steady_clock::now();
+            for (size_t offset = 0; offset + chunk <= audio.size(); offset += chunk) {
+                std::copy(audio.begin() + offset, audio.begin() + offset + chunk, block.begin());
+                FloatSpan samples = chain.active() ? chain.process(FloatSpan{block.data(), chunk})
+                                                   : FloatSpan{block.data(), chunk};
+                if (acceptWaveform(evalRec, samples)) {
+                    std::string text(extractTextFromJson(vosk_recognizer_result(evalRec)));
+                    if (!text.empty()) transcript += (transcript.empty() ? "" : " ") + text;
+                    lastPartial.clear();
+                } else {
+                    std::string partial(extractTextFromJson(vosk_recognizer_partial_result(evalRec)));
+                    if (partial != lastPartial) {
+                        partialUpdates++;
+                        lastPartial = partial;
+                    }
+                }
+            }
+            std::string text(extractTextFromJson(vosk_recognizer_final_result(evalRec)));
+            if (!text.empty()) transcript += (transcript.empty() ? "" : " ") + text;
+            double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            vosk_recognizer_free(evalRec);
             
-            // Store audio data in chunks for better memory management
-            for (size_t i = 0; i < sampleCount; i++) {
+            std::cout << "  " << variant.name << ": decode " << decodeSeconds << "s (RTF "
+                      << (decodeSeconds / audioSeconds) << "), " << partialUpdates << " partial updates";
+            if (!reference.empty()) {
+                std::cout << ", WER " << (100.0 * wordErrorRate(transcript, reference)) << "%";
+            }
+            std::cout << std::endl;
+            chain.report();
+        }
+        return true;
+    }
+    
+    // Microbenchmark for the recognizer feed path on synthetic audio: the old
+    // byte-buffer path (two vector copies + accept_waveform) against the typed
+    // span paths. Without a model only the pipeline overhead is measured.
+    void runFeedBenchmark(double seconds) {
+        const size_t chunk = modelSampleRate / 100;
+        const size_t chunks = static_cast<size_t>(seconds * 100);
+        AlignedBuffer<int16_t> pcm(chunk);
+        AlignedBuffer<float> pcmFloat(chunk);
+        uint32_t seed = 1;
+        for (size_t i = 0; i < chunk; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            pcm.data()[i] = static_cast<int16_t>((seed >> 16) % 2000) - 1000;
+            pcmFloat.data()[i] = pcm.data()[i];
+        }
+        
+        auto timeIt = [&](const char* name, double copiesPerSample, auto&& feed) {
+            if (rec) vosk_recognizer_reset(rec);
+            auto begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < chunks; i++) {
+                feed();
+            }
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+            std::cout << "  " << name << ": " << (ns / (chunks * chunk)) << " ns/sample, "
+                      << copiesPerSample << " copies/sample" << std::endl;
+        };
+        
+        std::cout << "⏱️ Feed benchmark, " << seconds << "s of audio in 10 ms chunks"
+                  << (rec ? "" : " (no model, pipeline only)") << std::endl;
+        
+        std::vector<int16_t> chunkBuffer;
+        std::vector<int16_t> audioData;
+        timeIt("bytes  (legacy)", 2.0, [&] {
+            const char* buffer = reinterpret_cast<const char*>(pcm.data());
+            const int16_t* samples = reinterpret_cast<const int16_t*>(buffer);
+            for (size_t i = 0; i < chunk; i++) {
                 chunkBuffer.push_back(samples[i]);
                 audioData.push_back(samples[i]);
             }
-            
-            // More frequent audio level updates for real-time feedback
-            updateCounter++;
-            if (updateCounter % 2 == 0) { // Update every 2 chunks (~80ms)
-                int level = calculateAudioLevel(samples, sampleCount);
-                writeAudioLevel(level);
+            if (rec) vosk_recognizer_accept_waveform(rec, buffer, chunk * sizeof(int16_t));
+        });
+        timeIt("int16  span    ", 0.0, [&] {
+            Int16Span samples = pcm.span(chunk);
+            if (rec) acceptWaveform(rec, samples);
+            benchmarkSink += samples.data[0];
+        });
+        timeIt("float  span    ", 0.0, [&] {
+            FloatSpan samples = pcmFloat.span(chunk);
+            if (rec) acceptWaveform(rec, samples);
+            benchmarkSink += samples.data[0];
+        });
+        
+        Prefilter benchPrefilter;
+        RecorderSettings filterSettings = settings;
+        filterSettings.prefilterMicrophone = true;
+        benchPrefilter.configure(filterSettings, 1, modelSampleRate, chunk);
+        AlignedBuffer<float> filtered(chunk);
+        timeIt("prefilter span ", 0.0, [&] {
+            std::copy(pcmFloat.data(), pcmFloat.data() + chunk, filtered.data());
+            FloatSpan samples = benchPrefilter.process(filtered.span(chunk));
+            if (rec) acceptWaveform(rec, samples);
+            benchmarkSink += samples.data[0];
+        });
+        if (rec) vosk_recognizer_reset(rec);
+    }
+    
+    // Runs the recording pipeline (status files, archive, DSP, endpointing,
+    // and the recognizer when a model is loaded) over synthetic 1.5 s bursts
+    // of noise and silence, and counts the recording thread's heap
+    // allocations per audio second once the first second has warmed it up.
+    void runAllocationBenchmark(double seconds) {
+        const size_t chunk = modelSampleRate / 100;
+        const size_t chunks = static_cast<size_t>(seconds * 100);
+        AlignedBuffer<int16_t> pcm(chunk);
+        RecorderSettings saved = settings;
+        settings.transcriptIndex = false;   // keep noise out of the history
+        settings.translation = false;
+        beginSession("alloc_bench_");
+        std::string archivePath = archiving ? archive.path() : "";
+        
+        uint32_t seed = 1;
+        uint64_t warmAllocations = AllocationCounter::allocations;
+        uint64_t warmRecognizer = 0;
+        for (size_t c = 0; c < chunks; c++) {
+            int amplitude = (c / 150) % 2 == 0 ? 3000 : 30;
+            for (size_t i = 0; i < chunk; i++) {
+                seed = seed * 1664525u + 1013904223u;
+                pcm.data()[i] = static_cast<int16_t>(static_cast<int>((seed >> 16) % (2 * amplitude)) - amplitude);
+            }
+            if (c == 100) {
+                warmAllocations = AllocationCounter::allocations;
+                warmRecognizer = recognizerAllocations;
+            }
+            Int16Span samples = pcm.span(chunk);
+            trackLevel(samples);
+            processChunk(samples);
+            pollControl();
+            if (c % 8 == 0) publishLevel();    // what the timers do every 80 ms and 1 s
+            if (c % 100 == 0) printStatus();
+        }
+        double measured = seconds - 1.0;
+        std::cout << "\n⏱️ Allocation benchmark, " << seconds << "s of audio in 10 ms chunks"
+                  << (rec ? "" : " (no model, pipeline only)") << ": "
+                  << (AllocationCounter::allocations - warmAllocations) / measured
+                  << " heap allocations per audio second on the recording thread after the first second, "
+                  << (recognizerAllocations - warmRecognizer) / measured << " inside Vosk" << std::endl;
+        endSession();
+        settings = saved;
+        if (!archivePath.empty()) {
+            std::string cleanup = "rm -rf '" + archivePath + "'";
+            if (system(cleanup.c_str()) != 0) {
+                std::cerr << "⚠️ Could not remove " << archivePath << std::endl;
+            }
+        }
+    }
+    
+    // Translation stage under caption load with the stand-in model: segments
+    // drawn (with repeats, like captions) from a small phrase pool arrive
+    // faster than one model call per segment can keep up with. Compares
+    // one-at-a-time against batched, without and with the cache.
+    void runTranslationBenchmark(size_t count) {
+        static const char* const phrases[] = {
+            "merhaba herkese", "bugün toplantımız var", "ekranı paylaşabilir misin",
+            "sesim geliyor mu", "bir dakika lütfen", "evet katılıyorum", "bunu sonra konuşalım",
+            "sunumu açıyorum", "sorusu olan var mı", "teşekkürler", "tamam devam edelim",
+            "kayıt başladı mı", "bağlantım koptu", "tekrar eder misin", "görüşmek üzere",
+            "bir sonraki slayta geçelim", "rakamlar geçen aydan daha iyi", "bütçe onaylandı",
+            "yarın saat onda", "notları paylaşacağım",
+        };
+        const size_t pool = sizeof(phrases) / sizeof(phrases[0]);
+        std::vector<std::string> stream;
+        uint32_t seed = 1;
+        for (size_t i = 0; i < count; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            double u = (seed >> 8) / 16777216.0;
+            stream.push_back(phrases[static_cast<size_t>(u * u * pool)]);   // skewed towards the first phrases
+        }
+        
+        RecorderSettings benchSettings = settings;
+        benchSettings.translationModel = "stand-in";
+        std::cout << "⏱️ Translation benchmark, " << count << " segments, one every 3 ms" << std::endl;
+        
+        auto run = [&](const char* name, size_t batch, size_t cacheEntries) {
+            TranslationWorker worker;
+            worker.start(TranslationWorker::create(benchSettings), batch, cacheEntries, "en");
+            size_t received = 0;
+            auto begin = std::chrono::steady_clock::now();
+            for (const std::string& text : stream) {
+                worker.submit(text, "tr");
+                std::this_thread::sleep_for(std::chrono::milliseconds(3));
+                worker.poll([&](const std::string&) { received++; });
+            }
+            worker.stop();
+            worker.poll([&](const std::string&) { received++; });
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            std::cout << "  " << name << ": " << (received / seconds) << " segments/s" << std::endl << "  ";
+            worker.report();
+        };
+        run("batch 1, no cache ", 1, 0);
+        run("batch 8, no cache ", 8, 0);
+        run("batch 8, LRU cache", 8, 1024);
+    }
+    
+    // Searches the transcript history; prints where each hit is in its
+    // session archive.
+    bool runSearch(const std::string& query, size_t limit) {
+        TranscriptIndex index;
+        if (!index.open(settings.transcriptDir, false)) {
+            std::cerr << "❌ No transcript index in " << settings.transcriptDir << std::endl;
+            return false;
+        }
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<TranscriptIndex::Hit> hits = index.search(query, limit);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        for (const TranscriptIndex::Hit& hit : hits) {
+            uint64_t seconds = hit.range.begin / static_cast<uint64_t>(hit.sampleRate);
+            char offset[32];
+            snprintf(offset, sizeof(offset), "%llu:%02llu:%02llu", static_cast<unsigned long long>(seconds / 3600),
+                     static_cast<unsigned long long>(seconds / 60 % 60), static_cast<unsigned long long>(seconds % 60));
+            std::cout << (hit.archive.empty() ? "(no archive)" : hit.archive) << " @ " << offset
+                      << " [samples " << hit.range.begin << "-" << hit.range.end << "] " << hit.text << std::endl;
+        }
+        std::cout << "🔎 " << hits.size() << " hits in " << ms << " ms (" << index.segmentCount()
+                  << " segments)" << std::endl;
+        return true;
+    }
+    
+    // Builds a synthetic history of `hours` of speech (~150 words a minute in
+    // 10-word segments, Zipf-distributed vocabulary) through the same
+    // incremental path as recording, then times word and phrase queries.
+    void runSearchBenchmark(double hours) {
+        char pattern[] = "/tmp/s2t-index-XXXXXX";
+        if (!mkdtemp(pattern)) return;
+        std::string directory = pattern;
+        const size_t vocabulary = 20000;
+        const uint64_t segmentCount = static_cast<uint64_t>(hours * 60 * 15);
+        std::vector<std::string> words(vocabulary);
+        for (size_t i = 0; i < vocabulary; i++) words[i] = "w" + std::to_string(i);
+        
+        TranscriptIndex index;
+        index.open(directory, true);
+        index.setDurable(false);   // measures indexing, not the disk's fsync latency
+        uint32_t session = index.beginSession("synthetic", modelSampleRate);
+        uint32_t seed = 1;
+        std::string text;
+        auto begin = std::chrono::steady_clock::now();
+        for (uint64_t s = 0; s < segmentCount; s++) {
+            text.clear();
+            for (int w = 0; w < 10; w++) {
+                seed = seed * 1664525u + 1013904223u;
+                double u = ((seed >> 8) + 1) / 16777217.0;
+                size_t rank = static_cast<size_t>(std::pow(static_cast<double>(vocabulary), u)) - 1;
+                text += (w ? " " : "") + words[std::min(rank, vocabulary - 1)];
             }
+            StreamRange range{s * 4 * modelSampleRate, (s + 1) * 4 * modelSampleRate};
+            index.add(session, range, "en", text);
+            if ((s + 1) % settings.indexFlushSegments == 0) index.flush();
+        }
+        index.flush();
+        double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << "⏱️ Search benchmark: " << hours << " h, " << segmentCount << " segments indexed in "
+                  << buildSeconds << " s, " << index.runCount() << " runs" << std::endl;
+        
+        TranscriptIndex reader;
+        reader.open(directory, false);
+        const char* queries[] = {"w3", "w500", "w15000", "w1 w2", "w40 w900", "\"w0 w1\"", "w19999 w7"};
+        for (const char* query : queries) {
+            auto start = std::chrono::steady_clock::now();
+            size_t hits = reader.search(query, 20).size();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "  " << query << ": " << hits << " hits in " << ms << " ms" << std::endl;
+        }
+        
+        std::string cleanup = "rm -rf '" + directory + "'";
+        if (system(cleanup.c_str()) != 0) {
+            std::cerr << "⚠️ Could not remove " << directory << std::endl;
+        }
+    }
+    
+    // Decode workers shared by the parallel lanes and the server; started on
+    // first use, on the decode cores (see CaptureReader::decodeCpus).
+    TaskScheduler& decodeScheduler() {
+        if (!scheduler.running()) {
+            scheduler.start(settings.decodeWorkers, CaptureReader::decodeCpus(settings));
+        }
+        return scheduler;
+    }
+    
+    // Synthetic streams with uneven decode cost (1-4x) on 1, 2, 4, ... workers.
+    // Each run measures throughput with every chunk queued up front, then
+    // per-stream p99 latency (post to decoded) with chunks arriving every
+    // 20 ms at a load of 70% of all cores, so the smaller pools are
+    // overloaded and the full pool is not.
+    void runSchedulerBenchmark(int streams, double seconds) {
+        int cores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        if (streams <= 0) streams = 4 * cores;
+        const double chunkMs = 20.0;
+        double factorSum = 0.0;
+        for (int i = 0; i < streams; i++) factorSum += 1 + i % 4;
+        const double baseMs = 0.7 * cores * chunkMs / factorSum;
+        const size_t chunks = static_cast<size_t>(seconds * 1000.0 / chunkMs);
+        auto spin = [](double ms) {
+            auto until = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(ms);
+            while (std::chrono::steady_clock::now() < until) {}
+        };
+        
+        std::cout << "⏱️ Scheduler benchmark: " << streams << " streams x " << chunks << " chunks, "
+                  << baseMs << "-" << 4 * baseMs << " ms per chunk, " << cores << " cores" << std::endl;
+        double baseline = 0.0;
+        for (int workers = 1; ; workers = std::min(workers * 2, cores)) {
+            TaskScheduler pool;
+            pool.start(workers);
+            std::vector<std::unique_ptr<Strand>> strands;
+            for (int i = 0; i < streams; i++) strands.push_back(std::make_unique<Strand>(pool));
             
-            // Immediate speech recognition processing
-            if (rec) {
-                // Always get partial result for real-time updates
-                const char* partialResult = vosk_recognizer_partial_result(rec);
-                std::string partialText = extractTextFromJson(std::string(partialResult));
-                if (!partialText.empty()) {
-                    writePartialText(partialText);
-                }
-                
-                // Check for final result
-                if (vosk_recognizer_accept_waveform(rec, buffer, bytesRead)) {
-                    const char* result = vosk_recognizer_result(rec);
-                    std::string text = extractTextFromJson(std::string(result));
-                    if (!text.empty()) {
-                        std::cout << "\n🔊 " << text << std::endl;
-                        writeRecognizedText(text);
-                    }
+            auto begin = std::chrono::steady_clock::now();
+            for (size_t c = 0; c < chunks; c++) {
+                for (int i = 0; i < streams; i++) {
+                    strands[i]->post([&spin, cost = baseMs * (1 + i % 4)] { spin(cost); });
                 }
             }
+            for (auto& strand : strands) strand->drain();
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            double throughput = chunks * streams / elapsed;
+            if (workers == 1) baseline = throughput;
             
-            // Periodic status (less frequent to reduce overhead)
-            if (updateCounter % 25 == 0) { // Every ~1 second
-                int elapsedSeconds = time(nullptr) - startTime;
-                std::cout << "\r🔴 " << elapsedSeconds << "s [";
-                int level = calculateAudioLevel(samples, sampleCount);
-                for (int i = 0; i < 10; i++) {
-                    std::cout << (i < level ? "=" : " ");
+            std::vector<std::vector<double>> latencies(streams);   // each written by its own strand
+            begin = std::chrono::steady_clock::now();
+            for (size_t c = 0; c < chunks; c++) {
+                std::this_thread::sleep_until(begin + std::chrono::duration<double, std::milli>(chunkMs * c));
+                auto posted = std::chrono::steady_clock::now();
+                for (int i = 0; i < streams; i++) {
+                    strands[i]->post([&spin, &latencies, i, posted, cost = baseMs * (1 + i % 4)] {
+                        spin(cost);
+                        latencies[i].push_back(std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - posted).count());
+                    });
                 }
-                std::cout << "] " << (totalBytes/1024) << "KB" << std::flush;
             }
+            for (auto& strand : strands) strand->drain();
+            std::vector<double> p99s;
+            for (auto& stream : latencies) {
+                std::sort(stream.begin(), stream.end());
+                p99s.push_back(stream[stream.size() * 99 / 100]);
+            }
+            std::sort(p99s.begin(), p99s.end());
+            
+            std::cout << "  " << workers << " workers: " << static_cast<uint64_t>(throughput) << " chunks/s ("
+                      << throughput / baseline << "x), real-time p99 median stream " << p99s[p99s.size() / 2]
+                      << " ms, worst stream " << p99s.back() << " ms" << std::endl;
+            std::cout << "  ";
+            pool.report();
+            strands.clear();
+            if (workers == cores) break;
         }
+    }
+    
+    // Server mode: transcribes PCM streams from local clients (see
+    // transcription_server.h) until SIGINT/SIGTERM.
+    bool runServer() {
+        serverSignals::install();
+        TranscriptionServer server(model, decodeScheduler());
+        bool served = server.run(settings.serverSocket, settings, [] { return serverSignals::quit != 0; });
+        scheduler.report();
+        return served;
+    }
+    
+    // Drives an in-process server with synthetic clients. Client 0 sends as
+    // fast as it can; the others stream in real time. With fair scheduling
+    // the real-time clients still get their results shortly after they stop
+    // sending, however far ahead client 0 is.
+    void runServerBenchmark(int clients, double seconds) {
+        const std::string socketPath = "serve-bench.sock";
+        RecorderSettings benchSettings = settings;
+        benchSettings.serverReportSeconds = 0;
+        TranscriptionServer server(model, decodeScheduler());
+        std::atomic<bool> finished{false};
+        std::thread serving([&] { server.run(socketPath, benchSettings, [&] { return finished.load(); }); });
         
-        pclose(pipe);
-        
-        // Final recognition
-        if (rec) {
-            const char* finalResult = vosk_recognizer_final_result(rec);
-            std::string text = extractTextFromJson(std::string(finalResult));
-            if (!text.empty()) {
-                std::cout << "\n🔊 " << text << std::endl;
-                writeRecognizedText(text);
+        struct Result {
+            size_t finals = 0;
+            std::string done;
+            double tailMs = 0.0;   // from the last byte sent to "done"
+        };
+        std::vector<Result> results(clients);
+        auto client = [&](int index) {
+            int fd = -1;
+            sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+            for (int attempt = 0; attempt < 100; attempt++) {
+                fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) break;
+                close(fd);
+                fd = -1;
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            if (fd < 0) return;
+            
+            std::string header = "pcm " + std::to_string(modelSampleRate) + "\n";
+            ::send(fd, header.data(), header.size(), MSG_NOSIGNAL);
+            const size_t chunk = modelSampleRate / 50;   // 20 ms
+            std::vector<int16_t> pcm(chunk);
+            uint32_t seed = 1 + index;
+            auto start = std::chrono::steady_clock::now();
+            size_t chunks = static_cast<size_t>(seconds * 50);
+            for (size_t c = 0; c < chunks; c++) {
+                for (int16_t& s : pcm) {
+                    seed = seed * 1664525u + 1013904223u;
+                    s = static_cast<int16_t>((seed >> 16) % 2000) - 1000;
+                }
+                ::send(fd, pcm.data(), pcm.size() * sizeof(int16_t), MSG_NOSIGNAL);
+                if (index > 0) std::this_thread::sleep_until(start + std::chrono::milliseconds(20 * (c + 1)));
             }
+            shutdown(fd, SHUT_WR);
+            auto sent = std::chrono::steady_clock::now();
+            
+            std::string received;
+            char buffer[4096];
+            ssize_t n;
+            while ((n = read(fd, buffer, sizeof(buffer))) > 0) received.append(buffer, n);
+            close(fd);
+            Result& result = results[index];
+            result.tailMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sent).count();
+            std::istringstream lines(received);
+            std::string line;
+            while (std::getline(lines, line)) {
+                if (line.compare(0, 6, "final ") == 0) result.finals++;
+                if (line.compare(0, 5, "done ") == 0) result.done = line.substr(5);
+            }
+        };
+        
+        std::cout << "⏱️ Server benchmark: " << clients << " clients x " << seconds << "s" << std::endl;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < clients; i++) threads.emplace_back(client, i);
+        for (auto& thread : threads) thread.join();
+        finished = true;
+        serving.join();
+        
+        for (int i = 0; i < clients; i++) {
+            std::cout << "  client " << i << (i == 0 ? " (flood)    " : " (real time)") << ": "
+                      << results[i].finals << " finals, " << results[i].done << ", done "
+                      << results[i].tailMs << " ms after its last byte" << std::endl;
+        }
+        scheduler.report();
+    }
+    
+    // Resident mode: the model stays loaded and capture keeps running into the
+    // pre-roll ring. SIGUSR1 starts a session (replaying the ring first),
+    // SIGUSR2 ends it, SIGINT/SIGTERM exit.
+    bool runDaemon(int mode) {
+        std::string command;
+        std::string sourceType;
+        std::string outputPrefix;
+        if (!buildCaptureCommand(mode, command, sourceType, outputPrefix)) {
+            return false;
         }
         
-        // Save audio file
-        if (!audioData.empty()) {
-            std::cout << "\n💾 Saving: " << outputFilename << std::endl;
-            saveWAVFile(outputFilename);
-            std::cout << "✅ Completed!" << std::endl;
+        FILE* pipe = popen(command.c_str(), "r");
+        if (!pipe) {
+            std::cerr << "❌ Could not start audio capture!" << std::endl;
+            return false;
         }
         
-        writeAudioLevel(0);
+        EventLoop loop;
+        StopDeadline exiting;
+        PreRollRing preRoll;
+        bool recording = false;
+        loop.watchSignals({SIGINT, SIGTERM, SIGUSR1, SIGUSR2}, [&](int signal) {
+            if (signal == SIGUSR1 && !recording) {
+                clearFiles();
+                beginSession(outputPrefix);
+                size_t replayed = preRoll.drain([this](int16_t* data, size_t count) {
+                    processChunk(Int16Span{data, count});
+                });
+                recording = true;
+                std::cout << "\n🎤 " << sourceType << " recording started with "
+                          << (static_cast<double>(replayed) / modelSampleRate) << "s pre-roll" << std::endl;
+            } else if (signal == SIGUSR2 && recording) {
+                // Bounded for the report and the drain; the daemon lives on
+                StopDeadline stopping;
+                stopping.start(settings.stopDeadlineMs, false);
+                drainCapture(stopping);
+                endSession(stopping);
+                if (rec) vosk_recognizer_reset(rec);
+                recording = false;
+                std::cout << "⏸️ Idle, pre-roll ring "
+                          << preRoll.cpuMicrosPerSecond() << "µs CPU per audio second" << std::endl;
+            } else if (signal == SIGINT || signal == SIGTERM) {
+                exiting.start(settings.stopDeadlineMs, true);
+                loop.stop();
+            }
+        });
+        startCapture(pipe);
+        control.open(CONTROL_SOCKET);
+        preRoll.configure(settings.preRollSeconds, modelSampleRate, settings.preRollVad);
+        std::cout << "🟢 " << sourceType << " daemon ready (pid " << getpid() << ", "
+                  << preRoll.seconds() << "s pre-roll)" << std::endl;
+        
+        watchCapture(loop, [&](auto samples) {
+            if (recording) {
+                trackLevel(samples);
+                processChunk(samples);
+            } else {
+                preRoll.write(samples.data, samples.size);
+            }
+        });
+        watchTimers(loop, recording);
+        loop.run();
+        
+        exiting.start(settings.stopDeadlineMs, true);
+        exiting.phase("capture");
+        capture.stop();
+        pclose(pipe);
+        if (recording) {
+            drainCapture(exiting);
+            endSession(exiting);
+        }
         return true;
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     AudioRecorder recorder;
+    recorder.loadSettings();
+    
+    // --set key=value overrides may appear anywhere on the command line
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--set" && i + 1 < argc) {
+            recorder.overrideSetting(argv[++i]);
+        } else {
+            args.push_back(arg);
+        }
+    }
+    std::string command = args.empty() ? "" : args[0];
     
-    if (!recorder.initialize()) {
+    // History search needs no model
+    if (command == "--search" && args.size() > 1) {
+        return recorder.runSearch(args[1], args.size() > 2 ? std::strtoul(args[2].c_str(), nullptr, 10) : 20) ? 0 : 1;
+    }
+    if (command == "--bench-search") {
+        recorder.runSearchBenchmark(args.size() > 1 ? std::atof(args[1].c_str()) : 100.0);
+        return 0;
+    }
+    
+    // Recording and the daemon take these signals through the event loop's
+    // signalfd, which only works if no thread leaves them unblocked: the
+    // kernel would deliver them there and the default action would end the
+    // process. initialize() starts the writer thread (and Vosk may start its
+    // own), so they are blocked around it and inherited by those threads.
+    // main's own mask is restored afterwards; record() and runDaemon() block
+    // them again before starting anything else.
+    sigset_t loopSignals, previousMask;
+    sigemptyset(&loopSignals);
+    for (int signal : {SIGINT, SIGTERM, SIGUSR1, SIGUSR2}) sigaddset(&loopSignals, signal);
+    pthread_sigmask(SIG_BLOCK, &loopSignals, &previousMask);
+    bool initialized = recorder.initialize();
+    pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+    
+    if (!initialized) {
         std::cout << "⚠️ Speech recognition disabled due to model loading failure." << std::endl;
     } else {
         std::cout << "✓ Speech recognition enabled." << std::endl;
     }
     
+    if (command == "--bench") {
+        recorder.runFeedBenchmark(args.size() > 1 ? std::atof(args[1].c_str()) : 60.0);
+        return 0;
+    }
+    
+    if (command == "--bench-alloc") {
+        recorder.runAllocationBenchmark(std::max(2.0, args.size() > 1 ? std::atof(args[1].c_str()) : 30.0));
+        return 0;
+    }
+    
+    if (command == "--bench-translation") {
+        recorder.runTranslationBenchmark(args.size() > 1 ? std::strtoul(args[1].c_str(), nullptr, 10) : 500);
+        return 0;
+    }
+    
+    if (command == "--eval" && args.size() > 1) {
+        return recorder.runEvaluation(args[1], args.size() > 2 ? args[2] : "") ? 0 : 1;
+    }
+    
+    if (command == "--serve") {
+        return recorder.runServer() ? 0 : 1;
+    }
+    
+    if (command == "--bench-scheduler") {
+        recorder.runSchedulerBenchmark(args.size() > 1 ? std::atoi(args[1].c_str()) : 0,
+                                       args.size() > 2 ? std::atof(args[2].c_str()) : 3.0);
+        return 0;
+    }
+    
+    if (command == "--serve-bench") {
+        recorder.runServerBenchmark(args.size() > 1 ? std::atoi(args[1].c_str()) : 8,
+                                    args.size() > 2 ? std::atof(args[2].c_str()) : 10.0);
+        return 0;
+    }
+    
+    if (command == "--daemon") {
+        int mode = args.size() > 1 ? std::atoi(args[1].c_str()) : 1;
+        return recorder.runDaemon(mode) ? 0 : 1;
+    }
+    
     std::cout << "\n🎤 Select Recording Mode:" << std::endl;
     std::cout << "1) Microphone" << std::endl;
     std::cout << "2) System audio" << std::endl;
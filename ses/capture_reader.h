@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "recorder_settings.h"
+#include "thread_policy.h"
+
+// Reads the parec pipe on a thread of its own, so capture keeps up while
+// the recording thread decodes. The reader does nothing but read fixed
+// chunks into a ring of preallocated blocks; it is the thread that gets
+// capture-policy and capture-cpus.
+//
+// Deadline accounting: each chunk is due when its last sample has been
+// captured, i.e. at the stream start plus the audio read so far. How late
+// a read returns relative to that is its lateness; the baseline is the
+// smallest lateness seen (parec's own buffering), allowed to creep up by
+// 1 ms per second so clock drift between the sound card and the system
+// clock is not counted. A read more than capture-deadline-ms behind the
+// baseline is a deadline miss: audio was sitting in the pipe because the
+// reader was not running, which is what ends in a parec overrun.
+//
+// readyFd() becomes readable when blocks are waiting (or the stream has
+// ended), for the recording thread's event loop.
+class CaptureReader {
+public:
+    CaptureReader() {
+        readyEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+
+    ~CaptureReader() {
+        stop();
+        if (readyEvent >= 0) ::close(readyEvent);
+    }
+
+    int readyFd() const { return readyEvent; }
+
+    // `chunkSamples` interleaved int16 samples per read; `frameRate` is the
+    // capture rate in frames per second.
+    void start(FILE* source, size_t chunkSamples, int channels, int frameRate, const RecorderSettings& settings) {
+        stop();
+        pipe = source;
+        samplesPerChunk = chunkSamples;
+        channelCount = std::max(1, channels);
+        rate = frameRate;
+        deadlineMs = settings.captureDeadlineMs;
+        policy = settings.capturePolicy;
+        priority = settings.capturePriority;
+        cpus = captureCpus(settings);
+        size_t slots = std::max<size_t>(4, static_cast<size_t>(settings.captureQueueMs) * rate / 1000 * channelCount
+                                              / std::max<size_t>(1, chunkSamples));
+        blocks.assign(slots, std::vector<int16_t>(chunkSamples));
+        lengths.assign(slots, 0);
+        head = tail = filled = 0;
+        finished = false;
+        stopping = false;
+        resetStats();
+        worker = std::thread(&CaptureReader::run, this);
+    }
+
+    // Cores the capture thread runs on: capture-cpus, or core 0 when
+    // capture-isolate keeps decode away from it on a machine with more than
+    // two cores.
+    static std::vector<int> captureCpus(const RecorderSettings& settings) {
+        std::vector<int> list = threadPolicy::parseCpuList(settings.captureCpus);
+        if (list.empty() && isolating(settings)) list.push_back(0);
+        return list;
+    }
+
+    // Cores for decode (the recording thread and the scheduler workers):
+    // decode-cpus, else every core but the capture ones when isolating.
+    static std::vector<int> decodeCpus(const RecorderSettings& settings) {
+        std::vector<int> list = threadPolicy::parseCpuList(settings.decodeCpus);
+        if (list.empty() && isolating(settings)) list = threadPolicy::otherCpus(captureCpus(settings));
+        return list;
+    }
+
+    // Copies the next chunk into `out` (room for chunkSamples) if one is
+    // waiting. Returns the number of samples, 0 when none is; `ended` is set
+    // once the stream is over and every chunk has been taken.
+    size_t tryRead(int16_t* out, bool& ended) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (filled == 0) {
+            // Consumes the wakeup; the reader signals again on the next block
+            uint64_t count;
+            if (::read(readyEvent, &count, sizeof(count)) < 0) {}
+            ended = finished;
+            return 0;
+        }
+        ended = false;
+        size_t count = lengths[tail];
+        memcpy(out, blocks[tail].data(), count * sizeof(int16_t));
+        tail = (tail + 1) % blocks.size();
+        filled--;
+        space.notify_one();
+        return count;
+    }
+
+    // Stops reading; the pipe stays open for the caller to close.
+    void stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        space.notify_one();
+        worker.join();
+    }
+
+    // Prints and clears the counters since the last report.
+    void report() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (reads == 0) return;
+        uint64_t below = 0;
+        size_t p99 = 0;
+        for (; p99 < lateHistogram.size(); p99++) {
+            below += lateHistogram[p99];
+            if (below * 100 >= reads * 99) break;
+        }
+        std::cout << "⏲️ Capture (" << (granted.empty() ? "normal priority" : granted) << ", cpus "
+                  << threadPolicy::describe(cpus) << "): " << reads << " reads, " << misses
+                  << " deadline misses (> " << deadlineMs << " ms late), p99 " << p99 << " ms, max "
+                  << maxLateMs << " ms late, " << stalls << " waits for the recording thread" << std::endl;
+        resetStats();
+    }
+
+private:
+    FILE* pipe = nullptr;
+    size_t samplesPerChunk = 0;
+    int channelCount = 1;
+    int rate = 16000;
+    int deadlineMs = 50;
+    std::string policy;
+    int priority = 10;
+    std::vector<int> cpus;
+    std::string granted;                  // what applyRealtime obtained; guarded by the mutex
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable space;
+    int readyEvent = -1;                  // eventfd, written when the queue becomes non-empty
+    std::vector<std::vector<int16_t>> blocks;
+    std::vector<size_t> lengths;
+    size_t head = 0;
+    size_t tail = 0;
+    size_t filled = 0;
+    bool finished = false;
+    bool stopping = false;
+
+    // Guarded by the mutex
+    uint64_t reads = 0;
+    uint64_t misses = 0;
+    uint64_t stalls = 0;
+    double maxLateMs = 0.0;
+    std::vector<uint64_t> lateHistogram;  // 1 ms buckets, last one open-ended
+
+    void resetStats() {
+        reads = misses = stalls = 0;
+        maxLateMs = 0.0;
+        lateHistogram.assign(1000, 0);
+    }
+
+    void run() {
+        if (!threadPolicy::setAffinity(cpus)) {
+            std::cerr << "⚠️ Capture: could not pin to cpus " << threadPolicy::describe(cpus) << std::endl;
+        }
+        // The rtkit call can take a while; report() may run meanwhile
+        std::string obtained = threadPolicy::applyRealtime(policy, priority, "Capture");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            granted = std::move(obtained);
+        }
+
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point begin = Clock::now();
+        bool started = false;
+        uint64_t frames = 0;
+        double baseline = 0.0;
+        double lastSeconds = 0.0;
+        bool late = false;
+        std::vector<int16_t> chunk(samplesPerChunk);
+        while (true) {
+            size_t bytes = fread(chunk.data(), 1, chunk.size() * sizeof(int16_t), pipe);
+            size_t count = bytes / sizeof(int16_t);
+            auto now = Clock::now();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (count == 0 || stopping) break;
+            if (!started) {
+                begin = now;
+                started = true;
+            } else {
+                double seconds = std::chrono::duration<double>(now - begin).count();
+                double lateMs = (seconds - static_cast<double>(frames) / rate) * 1000.0;
+                baseline = std::min(lateMs, baseline + (seconds - lastSeconds));   // +1 ms/s
+                lastSeconds = seconds;
+                double behind = lateMs - baseline;
+                lateHistogram[std::min<size_t>(static_cast<size_t>(behind), lateHistogram.size() - 1)]++;
+                maxLateMs = std::max(maxLateMs, behind);
+                if (behind > deadlineMs && !late) misses++;   // one per episode
+                late = behind > deadlineMs;
+            }
+            frames += count / channelCount;
+            reads++;
+
+            if (filled == blocks.size()) {
+                stalls++;
+                space.wait(lock, [this] { return filled < blocks.size() || stopping; });
+                if (stopping) break;
+            }
+            std::swap(blocks[head], chunk);
+            lengths[head] = count;
+            head = (head + 1) % blocks.size();
+            if (filled++ == 0) wake();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        wake();
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        if (::write(readyEvent, &one, sizeof(one)) < 0) {}
+    }
+
+    static bool isolating(const RecorderSettings& settings) {
+        return settings.captureIsolate && std::thread::hardware_concurrency() > 2;
+    }
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Line-based control socket (Unix stream socket in the working directory).
+//
+// Clients send commands such as "set noise-reduction false" and get one reply
+// line back. Everything is non-blocking and polled from the recording
+// thread's event loop, so handlers run on that thread and can touch
+// pipeline state without locking. fd() is an epoll set over the listening
+// socket and its clients; it is readable whenever poll() has work.
+class ControlChannel {
+public:
+    ~ControlChannel() {
+        close();
+    }
+
+    bool open(const std::string& socketPath) {
+        path = socketPath;
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) return false;
+
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(path.c_str());
+
+        readyFd = epoll_create1(EPOLL_CLOEXEC);
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listenFd, 4) != 0 || !watch(listenFd)) {
+            std::cerr << "⚠️ Control socket unavailable: " << path << " (" << strerror(errno) << ")" << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        for (auto& client : clients) {
+            ::close(client.fd);
+        }
+        clients.clear();
+        if (listenFd >= 0) {
+            ::close(listenFd);
+            listenFd = -1;
+            unlink(path.c_str());
+        }
+        if (readyFd >= 0) {
+            ::close(readyFd);
+            readyFd = -1;
+        }
+    }
+
+    int fd() const { return readyFd; }
+
+    // Accepts new clients and runs `handler(line) -> reply` for every complete
+    // command line received since the last call.
+    template <typename Handler>
+    void poll(Handler&& handler) {
+        if (listenFd < 0) return;
+
+        int accepted;
+        while ((accepted = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            clients.push_back({accepted, ""});
+            watch(accepted);
+        }
+
+        for (size_t i = 0; i < clients.size();) {
+            Client& client = clients[i];
+            char buffer[256];
+            ssize_t n;
+            bool closed = false;
+            while ((n = read(client.fd, buffer, sizeof(buffer))) > 0) {
+                client.pending.append(buffer, n);
+            }
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                closed = true;
+            }
+
+            size_t newline;
+            while ((newline = client.pending.find('\n')) != std::string::npos) {
+                std::string line = client.pending.substr(0, newline);
+                client.pending.erase(0, newline + 1);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty()) continue;
+                std::string reply = handler(line) + "\n";
+                // Clients may close without reading the reply; MSG_NOSIGNAL
+                // turns that into EPIPE instead of a process-ending SIGPIPE.
+                if (send(client.fd, reply.data(), reply.size(), MSG_NOSIGNAL) < 0) {
+                    closed = true;
+                }
+            }
+
+            if (closed) {
+                ::close(client.fd);
+                clients.erase(clients.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+
+private:
+    bool watch(int socketFd) {
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = socketFd;
+        return readyFd >= 0 && epoll_ctl(readyFd, EPOLL_CTL_ADD, socketFd, &event) == 0;
+    }
+
+    struct Client {
+        int fd;
+        std::string pending;
+    };
+
+    std::string path;
+    int listenFd = -1;
+    int readyFd = -1;
+    std::vector<Client> clients;
+};
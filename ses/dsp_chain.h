@@ -0,0 +1,92 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "agc.h"
+#include "noise_suppressor.h"
+#include "recorder_settings.h"
+#include "sample_span.h"
+
+// Float DSP stages that sit between capture and accept_waveform. Stages run
+// in place on float blocks; int16 input is widened once into a work buffer.
+// When every stage is off the capture span goes to the recognizer untouched.
+class DspChain {
+public:
+    void configure(const RecorderSettings& settings, int sampleRate) {
+        work.allocate(static_cast<size_t>(sampleRate) / 5);   // 200 ms, larger than any capture chunk
+        noiseSuppressor.reset();
+        agc.configure(sampleRate);
+        applySettings(settings);
+    }
+
+    // Safe to call between chunks, e.g. from the control channel.
+    void applySettings(const RecorderSettings& settings) {
+        if (settings.noiseReduction && !noiseReduction) {
+            noiseSuppressor.reset();
+        }
+        noiseReduction = settings.noiseReduction;
+        noiseSuppressor.setGainFloorDb(settings.noiseFloorDb);
+
+        automaticGain = settings.agc;
+        agc.setTargetDb(settings.agcTargetDb);
+        agc.setTimes(settings.agcAttackMs, settings.agcReleaseMs);
+        agc.setSensitivity(settings.microphoneSensitivity);
+    }
+
+    bool active() const { return noiseReduction || automaticGain; }
+
+    FloatSpan process(Int16Span samples) {
+        if (samples.size > work.capacity()) {
+            work.allocate(samples.size);
+        }
+        float* out = work.data();
+        for (size_t i = 0; i < samples.size; i++) {
+            out[i] = samples.data[i];
+        }
+        return process(FloatSpan{out, samples.size});
+    }
+
+    FloatSpan process(FloatSpan samples) {
+        if (noiseReduction) {
+            noiseSuppressor.process(samples.data, samples.size);
+        }
+        if (automaticGain) {
+            agc.process(samples.data, samples.size);
+        }
+        return samples;
+    }
+
+    // One-line snapshot for the control channel's "metrics" command
+    std::string metrics() const {
+        std::ostringstream line;
+        line << "agc-gain-db=" << agc.currentGainDb() << " agc-trajectory=";
+        bool first = true;
+        agc.forEachTrajectoryPoint([&](float db) {
+            line << (first ? "" : ",") << static_cast<int>(std::lround(db * 10)) / 10.0;
+            first = false;
+        });
+        line << " agc-limited=" << agc.limitedSamples()
+             << " ns-frame-us=" << noiseSuppressor.averageFrameMicros();
+        return line.str();
+    }
+
+    void report() const {
+        if (noiseSuppressor.frameCount() > 0) {
+            std::cout << "🔇 Noise suppression: " << noiseSuppressor.averageFrameMicros()
+                      << "µs per " << NoiseSuppressor::HOP << "-sample hop" << std::endl;
+        }
+        if (agc.blockCount() > 0) {
+            std::cout << "🎚️ AGC gain: " << agc.minGainDb() << " / " << agc.meanGainDb() << " / "
+                      << agc.maxGainDb() << " dB (min/mean/max), " << agc.limitedSamples()
+                      << " samples limited" << std::endl;
+        }
+    }
+
+private:
+    AlignedBuffer<float> work;
+    NoiseSuppressor noiseSuppressor;
+    AutomaticGainControl agc;
+    bool noiseReduction = false;
+    bool automaticGain = false;
+};
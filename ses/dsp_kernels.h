@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Small vector kernels shared by the DSP stages. SSE2 is part of the x86-64
+// baseline so it needs no extra compiler flags; other targets fall back to
+// plain loops.
+namespace dsp {
+
+// Sum of a[i] * b[i]. `n` should be a multiple of 8 for the SIMD path to
+// cover everything; the scalar tail handles the rest.
+inline float dot(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc0);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// Interleaved int16 frames to mono float (channel average), int16 scale.
+inline void downmixToFloat(const int16_t* in, size_t frames, int channels, float* out) {
+    if (channels == 1) {
+        for (size_t i = 0; i < frames; i++) {
+            out[i] = in[i];
+        }
+        return;
+    }
+    const float scale = 1.0f / channels;
+    for (size_t i = 0; i < frames; i++) {
+        int32_t sum = 0;
+        for (int c = 0; c < channels; c++) {
+            sum += in[i * channels + c];
+        }
+        out[i] = sum * scale;
+    }
+}
+
+// Float (int16 scale) to int16 with rounding and saturation.
+inline void floatToInt16(const float* in, size_t count, int16_t* out) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 8 <= count; i += 8) {
+        __m128i lo = _mm_cvtps_epi32(_mm_loadu_ps(in + i));
+        __m128i hi = _mm_cvtps_epi32(_mm_loadu_ps(in + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+    }
+#endif
+    for (; i < count; i++) {
+        float v = in[i];
+        v = v > 32767.0f ? 32767.0f : (v < -32768.0f ? -32768.0f : v);
+        out[i] = static_cast<int16_t>(v < 0 ? v - 0.5f : v + 0.5f);
+    }
+}
+
+} // namespace dsp
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "recorder_settings.h"
+#include "sample_span.h"
+
+// Span of an utterance in stream samples since the start of the session,
+// which is also its sample offset in the session archive.
+struct StreamRange {
+    uint64_t begin = 0;
+    uint64_t end = 0;
+};
+
+// Utterance endpointing on top of the recognizer's own.
+//
+// With endpoint-silence-ms at 0 the model decides when an utterance ends.
+// Otherwise an energy VAD over the recognizer feed decides: model finals
+// that arrive before the configured trailing silence are held and merged
+// (longer endpoints for dictation), and an utterance is force-finalized
+// once the silence is reached even if the model has not ended it yet
+// (shorter endpoints for captions). endpoint-max-seconds caps utterance
+// length in both modes.
+//
+// Time-to-final is measured in stream time, from the end of the last
+// speech frame to the chunk that produced the final result.
+class Endpointer {
+public:
+    enum class Reason { None, Model, Silence, MaxLength, SessionEnd };
+
+    void configure(const RecorderSettings& settings, int rate) {
+        sampleRate = rate;
+        frameSamples = static_cast<size_t>(rate) / 100;    // 10 ms
+        frameFill = 0;
+        frameSum = 0.0;
+        noiseFloor = -1.0;
+        position = 0;
+        utterances.clear();
+        resetUtterance();
+        applySettings(settings);
+    }
+
+    void applySettings(const RecorderSettings& settings) {
+        silenceSamples = static_cast<uint64_t>(settings.endpointSilenceMs) * sampleRate / 1000;
+        maxSamples = static_cast<uint64_t>(settings.endpointMaxSeconds * sampleRate);
+        minLevel = settings.endpointVadLevel;
+    }
+
+    // True when the endpointer, not the model, decides where utterances end.
+    bool holdsModelFinals() const { return silenceSamples > 0; }
+
+    // Runs the VAD over the samples just fed to the recognizer.
+    template <typename T>
+    void update(SampleSpan<T> samples) {
+        for (size_t i = 0; i < samples.size; i++) {
+            frameSum += std::abs(static_cast<float>(samples.data[i]));
+            if (++frameFill == frameSamples) {
+                onFrame(frameSum / frameSamples, position + i + 1);
+                frameFill = 0;
+                frameSum = 0.0;
+            }
+        }
+        position += samples.size;
+    }
+
+    // A model final was held. The model heard speech even when the VAD
+    // never rated a frame as such (a quiet microphone without AGC, or a
+    // noise floor that has risen toward the speech level); without this
+    // check() could not fire and the text would wait for the session end.
+    // Silence and the length cap then count from this first held final.
+    void modelFinal() {
+        if (speechSeen) return;
+        speechSeen = true;
+        utteranceStart = position;
+        lastSpeech = position;
+    }
+
+    // Speech has been seen since the last finalization.
+    bool inUtterance() const { return speechSeen; }
+
+    // From the speech onset (or the previous finalization) to now.
+    StreamRange utteranceRange() const { return {utteranceStart, position}; }
+
+    // Whether the current utterance should be finalized now, and why.
+    Reason check() const {
+        if (!speechSeen) return Reason::None;
+        if (maxSamples > 0 && position - utteranceStart >= maxSamples) return Reason::MaxLength;
+        if (silenceSamples > 0 && position - lastSpeech >= silenceSamples) return Reason::Silence;
+        return Reason::None;
+    }
+
+    // Records a finalized utterance and starts the next one.
+    void finalized(Reason reason) {
+        if (speechSeen) {
+            Utterance u;
+            u.reason = reason;
+            u.lengthMs = (lastSpeech - utteranceStart) * 1000 / sampleRate;
+            u.timeToFinalMs = (position - lastSpeech) * 1000 / sampleRate;
+            utterances.push_back(u);
+            std::cout << "\n⏱️ Final after " << u.timeToFinalMs << " ms (" << reasonName(reason) << ", "
+                      << u.lengthMs << " ms utterance)" << std::endl;
+        }
+        resetUtterance();
+    }
+
+    void report() const {
+        if (utterances.empty()) return;
+        std::vector<uint64_t> latencies;
+        for (const Utterance& u : utterances) latencies.push_back(u.timeToFinalMs);
+        std::sort(latencies.begin(), latencies.end());
+        uint64_t sum = 0;
+        for (uint64_t l : latencies) sum += l;
+
+        int counts[5] = {};
+        for (const Utterance& u : utterances) counts[static_cast<int>(u.reason)]++;
+        std::cout << "⏱️ Time-to-final over " << utterances.size() << " utterances: mean "
+                  << sum / latencies.size() << " ms, p50 " << latencies[latencies.size() / 2]
+                  << " ms, p90 " << latencies[latencies.size() * 9 / 10] << " ms (model " << counts[1]
+                  << ", silence " << counts[2] << ", max-length " << counts[3] << ", end "
+                  << counts[4] << ")" << std::endl;
+    }
+
+    static const char* reasonName(Reason reason) {
+        switch (reason) {
+            case Reason::Model: return "model";
+            case Reason::Silence: return "silence";
+            case Reason::MaxLength: return "max length";
+            case Reason::SessionEnd: return "session end";
+            default: return "none";
+        }
+    }
+
+private:
+    struct Utterance {
+        Reason reason;
+        uint64_t lengthMs;
+        uint64_t timeToFinalMs;
+    };
+
+    int sampleRate = 16000;
+    size_t frameSamples = 160;
+    size_t frameFill = 0;
+    double frameSum = 0.0;
+    double noiseFloor = -1.0;
+    float minLevel = 300.0f;
+
+    uint64_t silenceSamples = 0;
+    uint64_t maxSamples = 0;
+    uint64_t position = 0;
+    uint64_t utteranceStart = 0;
+    uint64_t lastSpeech = 0;
+    bool speechSeen = false;
+    std::vector<Utterance> utterances;
+
+    void resetUtterance() {
+        speechSeen = false;
+        utteranceStart = position;
+        lastSpeech = position;
+    }
+
+    // Same floor tracking as the pre-roll VAD: falls fast, rises slowly.
+    void onFrame(double level, uint64_t frameEnd) {
+        if (noiseFloor < 0) {
+            noiseFloor = level;
+        } else if (level < noiseFloor) {
+            noiseFloor = 0.9 * noiseFloor + 0.1 * level;
+        } else {
+            noiseFloor = 0.999 * noiseFloor + 0.001 * level;
+        }
+
+        if (level > minLevel && level > 3.0 * noiseFloor) {
+            if (!speechSeen) {
+                speechSeen = true;
+                utteranceStart = frameEnd - frameSamples;
+            }
+            lastSpeech = frameEnd;
+        }
+    }
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// One epoll loop for the recording thread: capture blocks, control socket
+// clients, periodic timers (timerfd) and signals (signalfd) all arrive as
+// readable descriptors, so each is handled as soon as it is ready rather
+// than between capture reads, and nothing runs in a signal handler.
+//
+// Handlers run on the thread that calls run(), in the order epoll reports
+// them; stop() from any handler ends run() once the current batch is done.
+class EventLoop {
+public:
+    using Handler = std::function<void()>;
+
+    EventLoop() {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+    }
+
+    ~EventLoop() {
+        for (int fd : owned) ::close(fd);
+        if (epollFd >= 0) ::close(epollFd);
+    }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Calls `onReadable` whenever `fd` has data (level-triggered).
+    bool watch(int fd, Handler onReadable) {
+        if (fd < 0 || epollFd < 0) return false;
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) return false;
+        handlers[fd] = std::move(onReadable);
+        return true;
+    }
+
+    void unwatch(int fd) {
+        if (handlers.erase(fd) > 0) epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    // Calls `onTick` every `intervalMs`. Expiries missed while the loop was
+    // busy are coalesced into one call.
+    bool every(int intervalMs, Handler onTick) {
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd < 0) return false;
+        itimerspec spec;
+        spec.it_interval.tv_sec = intervalMs / 1000;
+        spec.it_interval.tv_nsec = static_cast<long>(intervalMs % 1000) * 1000000L;
+        spec.it_value = spec.it_interval;
+        timerfd_settime(fd, 0, &spec, nullptr);
+        owned.push_back(fd);
+        return watch(fd, [fd, onTick = std::move(onTick)] {
+            uint64_t expirations;
+            if (read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)) onTick();
+        });
+    }
+
+    // Delivers `signals` to `onSignal` through the loop. They are blocked
+    // for the calling thread and every thread it starts afterwards, so call
+    // this before starting workers.
+    bool watchSignals(std::initializer_list<int> signals, std::function<void(int)> onSignal) {
+        sigset_t mask;
+        sigemptyset(&mask);
+        for (int signal : signals) sigaddset(&mask, signal);
+        pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+        int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (fd < 0) {
+            std::cerr << "⚠️ signalfd failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        owned.push_back(fd);
+        return watch(fd, [fd, onSignal = std::move(onSignal)] {
+            signalfd_siginfo info;
+            while (read(fd, &info, sizeof(info)) == sizeof(info)) onSignal(static_cast<int>(info.ssi_signo));
+        });
+    }
+
+    // Dispatches until stop().
+    void run() {
+        stopping = false;
+        epoll_event events[16];
+        while (!stopping) {
+            int count = epoll_wait(epollFd, events, 16, -1);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "❌ epoll_wait: " << strerror(errno) << std::endl;
+                return;
+            }
+            for (int i = 0; i < count; i++) {
+                // A handler may have unwatched a later fd in this batch
+                auto handler = handlers.find(events[i].data.fd);
+                if (handler != handlers.end()) handler->second();
+            }
+        }
+    }
+
+    void stop() {
+        stopping = true;
+    }
+
+private:
+    int epollFd = -1;
+    std::unordered_map<int, Handler> handlers;
+    std::vector<int> owned;               // timer and signal fds, closed with the loop
+    bool stopping = false;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// In-place iterative radix-2 complex FFT on split real/imaginary arrays.
+//
+// Twiddles are stored per stage and contiguous in j, so every stage with at
+// least four butterflies per group runs four butterflies per SSE instruction.
+// The two smallest stages are done in scalar code.
+class FFT {
+public:
+    void configure(size_t size) {
+        n = size;
+        bitReverse.resize(n);
+        size_t bits = 0;
+        while ((size_t(1) << bits) < n) bits++;
+        for (size_t i = 0; i < n; i++) {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; b++) {
+                if (i & (size_t(1) << b)) r |= size_t(1) << (bits - 1 - b);
+            }
+            bitReverse[i] = r;
+        }
+
+        // Stage with half-size h uses twiddles w^j = exp(-i*pi*j/h), j < h,
+        // stored at offset h - 1 (sizes 1 + 2 + 4 + ... = n - 1).
+        twiddleRe.assign(n, 0.0f);
+        twiddleIm.assign(n, 0.0f);
+        for (size_t half = 1; half < n; half <<= 1) {
+            for (size_t j = 0; j < half; j++) {
+                double angle = -M_PI * j / half;
+                twiddleRe[half - 1 + j] = static_cast<float>(std::cos(angle));
+                twiddleIm[half - 1 + j] = static_cast<float>(std::sin(angle));
+            }
+        }
+    }
+
+    size_t size() const { return n; }
+
+    void forward(float* re, float* im) const {
+        permute(re, im);
+        for (size_t half = 1; half < n; half <<= 1) {
+            const float* wr = &twiddleRe[half - 1];
+            const float* wi = &twiddleIm[half - 1];
+            for (size_t k = 0; k < n; k += 2 * half) {
+                butterflies(re + k, im + k, wr, wi, half);
+            }
+        }
+    }
+
+    // Unnormalized inverse via the conjugation trick; caller scales by 1/n.
+    void inverse(float* re, float* im) const {
+        for (size_t i = 0; i < n; i++) im[i] = -im[i];
+        forward(re, im);
+        for (size_t i = 0; i < n; i++) im[i] = -im[i];
+    }
+
+private:
+    size_t n = 0;
+    std::vector<size_t> bitReverse;
+    std::vector<float> twiddleRe;
+    std::vector<float> twiddleIm;
+
+    void permute(float* re, float* im) const {
+        for (size_t i = 0; i < n; i++) {
+            size_t r = bitReverse[i];
+            if (r > i) {
+                std::swap(re[i], re[r]);
+                std::swap(im[i], im[r]);
+            }
+        }
+    }
+
+    static void butterflies(float* re, float* im, const float* wr, const float* wi, size_t half) {
+        size_t j = 0;
+#if defined(__SSE2__)
+        for (; j + 4 <= half; j += 4) {
+            __m128 ar = _mm_loadu_ps(re + j);
+            __m128 ai = _mm_loadu_ps(im + j);
+            __m128 br = _mm_loadu_ps(re + j + half);
+            __m128 bi = _mm_loadu_ps(im + j + half);
+            __m128 cr = _mm_loadu_ps(wr + j);
+            __m128 ci = _mm_loadu_ps(wi + j);
+            __m128 tr = _mm_sub_ps(_mm_mul_ps(br, cr), _mm_mul_ps(bi, ci));
+            __m128 ti = _mm_add_ps(_mm_mul_ps(br, ci), _mm_mul_ps(bi, cr));
+            _mm_storeu_ps(re + j + half, _mm_sub_ps(ar, tr));
+            _mm_storeu_ps(im + j + half, _mm_sub_ps(ai, ti));
+            _mm_storeu_ps(re + j, _mm_add_ps(ar, tr));
+            _mm_storeu_ps(im + j, _mm_add_ps(ai, ti));
+        }
+#endif
+        for (; j < half; j++) {
+            float tr = re[j + half] * wr[j] - im[j + half] * wi[j];
+            float ti = re[j + half] * wi[j] + im[j + half] * wr[j];
+            re[j + half] = re[j] - tr;
+            im[j + half] = im[j] - ti;
+            re[j] += tr;
+            im[j] += ti;
+        }
+    }
+};
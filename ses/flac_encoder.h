@@ -0,0 +1,332 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Minimal streaming FLAC encoder for mono 16-bit PCM.
+//
+// Uses the fixed polynomial predictors (orders 0-4) with partitioned Rice
+// coding, which is what `flac -0`..`-2` produce and is plenty for speech.
+// Output is appended to a caller-owned byte buffer so the caller decides
+// where and when bytes hit the disk.
+class FlacBitWriter {
+public:
+    explicit FlacBitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void write(uint32_t value, int bits) {
+        if (bits == 0) return;
+        uint32_t mask = (bits == 32) ? 0xFFFFFFFFu : ((1u << bits) - 1);
+        acc = (acc << bits) | (value & mask);
+        accBits += bits;
+        while (accBits >= 8) {
+            accBits -= 8;
+            out.push_back(static_cast<uint8_t>(acc >> accBits));
+        }
+    }
+
+    void writeRice(int32_t residual, int k) {
+        uint32_t folded = (static_cast<uint32_t>(residual) << 1) ^ static_cast<uint32_t>(residual >> 31);
+        uint32_t quotient = folded >> k;
+        while (quotient >= 32) {
+            write(0, 32);
+            quotient -= 32;
+        }
+        write(1, quotient + 1);
+        write(folded, k);
+    }
+
+    void alignToByte() {
+        if (accBits) write(0, 8 - accBits);
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    uint64_t acc = 0;
+    int accBits = 0;
+};
+
+class FlacEncoder {
+public:
+    static constexpr uint32_t BLOCK_SIZE = 4096;
+    static constexpr size_t HEADER_SIZE = 42;   // "fLaC" + STREAMINFO block
+
+    explicit FlacEncoder(uint32_t sampleRate = 16000) : sampleRate(sampleRate) {
+        pending.reserve(BLOCK_SIZE);
+        residuals.resize(BLOCK_SIZE);
+    }
+
+    // Stream marker plus STREAMINFO. Call once before any frame and again at
+    // the end to get the patched version with final sample count and frame sizes.
+    void writeHeader(std::vector<uint8_t>& out) const {
+        const uint8_t marker[8] = {'f', 'L', 'a', 'C', 0x80, 0x00, 0x00, 0x22};
+        out.insert(out.end(), marker, marker + sizeof(marker));
+
+        FlacBitWriter bw(out);
+        bw.write(BLOCK_SIZE, 16);
+        bw.write(BLOCK_SIZE, 16);
+        bw.write(minFrameSize, 24);
+        bw.write(maxFrameSize, 24);
+        bw.write(sampleRate, 20);
+        bw.write(0, 3);                    // channels - 1
+        bw.write(15, 5);                   // bits per sample - 1
+        bw.write(static_cast<uint32_t>(totalSamples >> 32) & 0xF, 4);
+        bw.write(static_cast<uint32_t>(totalSamples), 32);
+        out.insert(out.end(), 16, 0);      // MD5 left unset (allowed by spec)
+    }
+
+    // Buffers samples and emits a frame every BLOCK_SIZE samples.
+    void encode(const int16_t* samples, size_t count, std::vector<uint8_t>& out) {
+        while (count > 0) {
+            size_t take = std::min(count, static_cast<size_t>(BLOCK_SIZE) - pending.size());
+            pending.insert(pending.end(), samples, samples + take);
+            samples += take;
+            count -= take;
+            if (pending.size() == BLOCK_SIZE) {
+                encodeFrame(pending.data(), BLOCK_SIZE, out);
+                pending.clear();
+            }
+        }
+    }
+
+    // Emits the final (possibly short) frame.
+    void flush(std::vector<uint8_t>& out) {
+        if (!pending.empty()) {
+            encodeFrame(pending.data(), static_cast<uint32_t>(pending.size()), out);
+            pending.clear();
+        }
+    }
+
+    uint64_t samplesEncoded() const { return totalSamples; }
+
+private:
+    uint32_t sampleRate;
+    uint64_t totalSamples = 0;
+    uint64_t frameNumber = 0;
+    uint32_t minFrameSize = 0;
+    uint32_t maxFrameSize = 0;
+    std::vector<int16_t> pending;
+    std::vector<int32_t> residuals;
+
+    static constexpr int MAX_ORDER = 4;
+    static constexpr int MAX_PARTITION_ORDER = 6;
+    static constexpr int MAX_RICE_PARAM = 14;
+
+    void encodeFrame(const int16_t* x, uint32_t n, std::vector<uint8_t>& out) {
+        size_t frameStart = out.size();
+        FlacBitWriter bw(out);
+
+        // Frame header: sync + fixed blocking, blocksize from 16-bit field,
+        // sample rate from STREAMINFO, mono, 16 bits per sample.
+        bw.write(0xFFF8, 16);
+        bw.write(0x7, 4);
+        bw.write(0x0, 4);
+        bw.write(0x0, 4);
+        bw.write(0x4, 3);
+        bw.write(0, 1);
+        writeUtf8Number(frameNumber, out);
+        bw.write(n - 1, 16);
+        out.push_back(crc8(out.data() + frameStart, out.size() - frameStart));
+
+        writeSubframe(x, n, bw);
+        bw.alignToByte();
+
+        uint16_t crc = crc16(out.data() + frameStart, out.size() - frameStart);
+        out.push_back(static_cast<uint8_t>(crc >> 8));
+        out.push_back(static_cast<uint8_t>(crc));
+
+        uint32_t frameSize = static_cast<uint32_t>(out.size() - frameStart);
+        if (minFrameSize == 0 || frameSize < minFrameSize) minFrameSize = frameSize;
+        if (frameSize > maxFrameSize) maxFrameSize = frameSize;
+        totalSamples += n;
+        frameNumber++;
+    }
+
+    void writeSubframe(const int16_t* x, uint32_t n, FlacBitWriter& bw) {
+        bool constant = true;
+        for (uint32_t i = 1; i < n && constant; i++) {
+            constant = (x[i] == x[0]);
+        }
+        if (constant) {
+            bw.write(0, 8);                // pad + CONSTANT + no wasted bits
+            bw.write(static_cast<uint16_t>(x[0]), 16);
+            return;
+        }
+
+        int bestOrder = -1;
+        int bestPartitionOrder = 0;
+        uint64_t bestBits = static_cast<uint64_t>(n) * 16;   // verbatim
+        int maxOrder = std::min<int>(MAX_ORDER, static_cast<int>(n) - 1);
+
+        for (int order = 0; order <= maxOrder; order++) {
+            computeResiduals(x, n, order);
+            int partitionOrder = 0;
+            uint64_t bits = static_cast<uint64_t>(order) * 16 + 6 +
+                            estimateResidualBits(n, order, partitionOrder, nullptr);
+            if (bits < bestBits) {
+                bestBits = bits;
+                bestOrder = order;
+                bestPartitionOrder = partitionOrder;
+            }
+        }
+
+        if (bestOrder < 0) {
+            bw.write(0x02, 8);             // pad + VERBATIM + no wasted bits
+            for (uint32_t i = 0; i < n; i++) {
+                bw.write(static_cast<uint16_t>(x[i]), 16);
+            }
+            return;
+        }
+
+        computeResiduals(x, n, bestOrder);
+        int params[1 << MAX_PARTITION_ORDER];
+        int partitionOrder = bestPartitionOrder;
+        estimateResidualBits(n, bestOrder, partitionOrder, params);
+
+        bw.write(0, 1);
+        bw.write(0x08 | bestOrder, 6);     // FIXED, order in low bits
+        bw.write(0, 1);
+        for (int i = 0; i < bestOrder; i++) {
+            bw.write(static_cast<uint16_t>(x[i]), 16);
+        }
+
+        bw.write(0, 2);                    // RICE, 4-bit parameters
+        bw.write(partitionOrder, 4);
+        uint32_t partitionSize = n >> partitionOrder;
+        uint32_t index = bestOrder;
+        for (int p = 0; p < (1 << partitionOrder); p++) {
+            uint32_t end = (p + 1) * partitionSize;
+            int k = params[p];
+            bw.write(k, 4);
+            for (; index < end; index++) {
+                bw.writeRice(residuals[index], k);
+            }
+        }
+    }
+
+    void computeResiduals(const int16_t* x, uint32_t n, int order) {
+        int32_t* r = residuals.data();
+        switch (order) {
+        case 0:
+            for (uint32_t i = 0; i < n; i++) r[i] = x[i];
+            break;
+        case 1:
+            for (uint32_t i = 1; i < n; i++) r[i] = x[i] - x[i - 1];
+            break;
+        case 2:
+            for (uint32_t i = 2; i < n; i++) r[i] = x[i] - 2 * x[i - 1] + x[i - 2];
+            break;
+        case 3:
+            for (uint32_t i = 3; i < n; i++) r[i] = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+            break;
+        case 4:
+            for (uint32_t i = 4; i < n; i++) {
+                r[i] = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4];
+            }
+            break;
+        }
+    }
+
+    // Picks the partition order and per-partition Rice parameters that minimise
+    // the (estimated) residual size. Sums are computed once at the finest
+    // partition order and merged for the coarser ones.
+    uint64_t estimateResidualBits(uint32_t n, int order, int& bestPartitionOrder, int* params) {
+        int maxPartitionOrder = 0;
+        while (maxPartitionOrder < MAX_PARTITION_ORDER &&
+               (n % (2u << maxPartitionOrder)) == 0 &&
+               (n >> (maxPartitionOrder + 1)) > static_cast<uint32_t>(order)) {
+            maxPartitionOrder++;
+        }
+
+        uint64_t sums[1 << MAX_PARTITION_ORDER];
+        uint32_t partitionSize = n >> maxPartitionOrder;
+        uint32_t index = order;
+        for (int p = 0; p < (1 << maxPartitionOrder); p++) {
+            uint64_t sum = 0;
+            uint32_t end = (p + 1) * partitionSize;
+            for (; index < end; index++) {
+                int32_t r = residuals[index];
+                sum += (static_cast<uint32_t>(r) << 1) ^ static_cast<uint32_t>(r >> 31);
+            }
+            sums[p] = sum;
+        }
+
+        uint64_t bestBits = UINT64_MAX;
+        for (int po = maxPartitionOrder; po >= 0; po--) {
+            if (po != maxPartitionOrder) {
+                for (int p = 0; p < (1 << po); p++) {
+                    sums[p] = sums[2 * p] + sums[2 * p + 1];
+                }
+            }
+            uint64_t bits = 0;
+            int chosen[1 << MAX_PARTITION_ORDER];
+            for (int p = 0; p < (1 << po); p++) {
+                uint32_t count = (n >> po) - (p == 0 ? order : 0);
+                bits += 4 + bestRiceBits(sums[p], count, chosen[p]);
+            }
+            if (bits < bestBits) {
+                bestBits = bits;
+                bestPartitionOrder = po;
+                if (params) std::memcpy(params, chosen, sizeof(int) * (1 << po));
+            }
+        }
+        return bestBits;
+    }
+
+    static uint64_t bestRiceBits(uint64_t sum, uint32_t count, int& param) {
+        uint64_t best = UINT64_MAX;
+        param = 0;
+        for (int k = 0; k <= MAX_RICE_PARAM; k++) {
+            uint64_t bits = static_cast<uint64_t>(count) * (k + 1) + (sum >> k);
+            if (bits < best) {
+                best = bits;
+                param = k;
+            }
+        }
+        return best;
+    }
+
+    static void writeUtf8Number(uint64_t value, std::vector<uint8_t>& out) {
+        if (value < 0x80) {
+            out.push_back(static_cast<uint8_t>(value));
+            return;
+        }
+        int bytes = 2;
+        while (bytes < 7 && value >= (1ull << (5 * bytes + 1))) bytes++;
+        out.push_back(static_cast<uint8_t>((0xFF00 >> bytes) | (value >> (6 * (bytes - 1)))));
+        for (int i = bytes - 2; i >= 0; i--) {
+            out.push_back(static_cast<uint8_t>(0x80 | ((value >> (6 * i)) & 0x3F)));
+        }
+    }
+
+    static uint8_t crc8(const uint8_t* data, size_t len) {
+        uint8_t crc = 0;
+        for (size_t i = 0; i < len; i++) {
+            crc ^= data[i];
+            for (int b = 0; b < 8; b++) {
+                crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    static uint16_t crc16(const uint8_t* data, size_t len) {
+        static const std::vector<uint16_t> table = [] {
+            std::vector<uint16_t> t(256);
+            for (int i = 0; i < 256; i++) {
+                uint16_t c = static_cast<uint16_t>(i << 8);
+                for (int b = 0; b < 8; b++) {
+                    c = (c & 0x8000) ? static_cast<uint16_t>((c << 1) ^ 0x8005) : static_cast<uint16_t>(c << 1);
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+        uint16_t crc = 0;
+        for (size_t i = 0; i < len; i++) {
+            crc = static_cast<uint16_t>((crc << 8) ^ table[((crc >> 8) ^ data[i]) & 0xFF]);
+        }
+        return crc;
+    }
+};
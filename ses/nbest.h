@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// One recognition hypothesis. For N-best results `confidence` is Vosk's
+// lattice score (larger is better, not normalized); a plain result has a
+// single hypothesis with confidence 0.
+struct Hypothesis {
+    std::string text;
+    double confidence = 0.0;
+};
+
+// Minimal single-pass reader for the two result shapes Vosk produces:
+//   {"text" : "..."}
+//   {"alternatives" : [{"confidence" : 312.4, "text" : "..."}, ...]}
+// Hypotheses are written into `out`, reusing its elements and string
+// capacity, so steady-state parsing does not allocate. `out` is never
+// shrunk: only the first parse() elements belong to the result.
+class ResultParser {
+public:
+    // Returns the number of hypotheses found (0 for an empty result).
+    static size_t parse(const char* json, std::vector<Hypothesis>& out) {
+        size_t count = 0;
+        const char* p = json;
+        double confidence = 0.0;
+        while ((p = nextKey(p))) {
+            const char* key = p + 1;
+            const char* keyEnd = skipString(p);
+            size_t keyLength = keyEnd - key - 1;
+            p = skipSpaceAndColon(keyEnd);
+
+            if (keyLength == 10 && std::string::traits_type::compare(key, "confidence", 10) == 0) {
+                char* end;
+                confidence = std::strtod(p, &end);
+                p = end;
+            } else if (keyLength == 4 && std::string::traits_type::compare(key, "text", 4) == 0 && *p == '"') {
+                if (out.size() <= count) out.emplace_back();
+                Hypothesis& h = out[count++];
+                h.confidence = confidence;
+                p = readString(p, h.text);
+                confidence = 0.0;
+            }
+        }
+        if (count == 1 && out[0].text.empty()) count = 0;
+        return count;
+    }
+
+    // Adds up the per-word "conf" values of a result produced with
+    // vosk_recognizer_set_words enabled.
+    static void wordConfidences(const char* json, double& sum, size_t& count) {
+        const char* p = json;
+        while ((p = nextKey(p))) {
+            const char* key = p + 1;
+            const char* keyEnd = skipString(p);
+            p = skipSpaceAndColon(keyEnd);
+            if (keyEnd - key - 1 == 4 && std::string::traits_type::compare(key, "conf", 4) == 0) {
+                char* end;
+                sum += std::strtod(p, &end);
+                count++;
+                p = end;
+            }
+        }
+    }
+
+private:
+    // Next '"' that starts an object key (preceded by '{' or ',').
+    static const char* nextKey(const char* p) {
+        char previous = 0;
+        while (*p) {
+            if (*p == '"') {
+                if (previous == '{' || previous == ',') return p;
+                p = skipString(p);
+                previous = '"';
+                continue;
+            }
+            if (*p != ' ' && *p != '\n' && *p != '\t' && *p != '\r') previous = *p;
+            p++;
+        }
+        return nullptr;
+    }
+
+    // p at an opening quote; returns the position after the closing quote.
+    static const char* skipString(const char* p) {
+        p++;
+        while (*p && *p != '"') {
+            if (*p == '\\' && p[1]) p++;
+            p++;
+        }
+        return *p ? p + 1 : p;
+    }
+
+    static const char* skipSpaceAndColon(const char* p) {
+        while (*p == ' ' || *p == ':' || *p == '\n' || *p == '\t') p++;
+        return p;
+    }
+
+    static const char* readString(const char* p, std::string& out) {
+        out.clear();
+        p++;
+        while (*p && *p != '"') {
+            if (*p == '\\' && p[1]) {
+                p++;
+                switch (*p) {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        // Vosk writes UTF-8 directly; \u escapes only appear for
+                        // control characters, which carry nothing for us.
+                        int skip = 0;
+                        while (skip < 4 && p[1]) { p++; skip++; }
+                        break;
+                    }
+                    default: out += *p; break;
+                }
+            } else {
+                out += *p;
+            }
+            p++;
+        }
+        return *p ? p + 1 : p;
+    }
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "fft.h"
+
+// Real-time spectral noise suppressor.
+//
+// 256-point STFT with a sqrt-Hann window and 50% overlap (16 ms frames at
+// 16 kHz). Per bin it tracks a noise floor that falls quickly and rises
+// slowly, estimates the a priori SNR with the decision-directed rule and
+// applies a Wiener gain limited by a floor, so residual noise stays natural
+// instead of turning into musical tones.
+//
+// Works in place on float blocks of any size; output is delayed by one frame.
+class NoiseSuppressor {
+public:
+    static constexpr size_t FRAME = 256;
+    static constexpr size_t HOP = FRAME / 2;
+    static constexpr size_t BINS = FRAME / 2 + 1;
+
+    NoiseSuppressor() {
+        fft.configure(FRAME);
+        window.resize(FRAME);
+        for (size_t i = 0; i < FRAME; i++) {
+            window[i] = static_cast<float>(std::sqrt(0.5 - 0.5 * std::cos(2.0 * M_PI * i / FRAME)));
+        }
+        re.resize(FRAME);
+        im.resize(FRAME);
+        noise.resize(BINS);
+        smoothed.resize(BINS);
+        prevGain.resize(BINS);
+        prevPower.resize(BINS);
+        reset();
+    }
+
+    void reset() {
+        input.assign(FRAME, 0.0f);
+        overlap.assign(FRAME, 0.0f);
+        output.assign(2 * FRAME, 0.0f);
+        inputFill = FRAME - HOP;
+        outputRead = 0;
+        outputWrite = HOP;             // primed with silence: one frame of latency overall
+        std::fill(noise.begin(), noise.end(), 0.0f);
+        std::fill(smoothed.begin(), smoothed.end(), 0.0f);
+        std::fill(prevGain.begin(), prevGain.end(), 1.0f);
+        std::fill(prevPower.begin(), prevPower.end(), 0.0f);
+        framesSeen = 0;
+    }
+
+    void setGainFloorDb(float db) {
+        gainFloor = std::pow(10.0f, db / 20.0f);
+    }
+
+    // Replaces samples[0..count) with the denoised signal from one frame ago.
+    void process(float* samples, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            input[inputFill++] = samples[i];
+            if (inputFill == FRAME) {
+                processFrame();
+                std::copy(input.begin() + HOP, input.end(), input.begin());
+                inputFill = FRAME - HOP;
+            }
+            samples[i] = output[outputRead];
+            outputRead = (outputRead + 1) % output.size();
+        }
+    }
+
+    double averageFrameMicros() const {
+        return frames ? busyMicros / frames : 0.0;
+    }
+
+    uint64_t frameCount() const { return frames; }
+
+private:
+    FFT fft;
+    std::vector<float> window;
+    std::vector<float> input;
+    std::vector<float> overlap;
+    std::vector<float> output;
+    std::vector<float> re;
+    std::vector<float> im;
+    std::vector<float> noise;
+    std::vector<float> smoothed;
+    std::vector<float> prevGain;
+    std::vector<float> prevPower;
+    size_t inputFill = 0;
+    size_t outputRead = 0;
+    size_t outputWrite = 0;
+    float gainFloor = 0.1f;           // -20 dB
+    uint64_t framesSeen = 0;
+    uint64_t frames = 0;
+    double busyMicros = 0.0;
+
+    static constexpr float DD_ALPHA = 0.98f;          // decision-directed smoothing
+    static constexpr float SMOOTHING = 0.8f;          // periodogram smoothing for tracking
+    static constexpr float MINIMUM_BIAS = 2.0f;
+    static constexpr float NOISE_FALL = 0.80f;        // fast tracking downwards
+    static constexpr float NOISE_RISE = 1.002f;       // ~+1.5 dB/s upwards
+    static constexpr uint64_t WARMUP_FRAMES = 8;
+
+    void processFrame() {
+        auto begin = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < FRAME; i++) {
+            re[i] = input[i] * window[i];
+            im[i] = 0.0f;
+        }
+        fft.forward(re.data(), im.data());
+
+        for (size_t k = 0; k < BINS; k++) {
+            float power = re[k] * re[k] + im[k] * im[k] + 1e-3f;
+
+            // Track the floor of the smoothed periodogram, then correct for the
+            // bias of following its minima rather than its mean.
+            smoothed[k] = SMOOTHING * smoothed[k] + (1.0f - SMOOTHING) * power;
+            if (framesSeen < WARMUP_FRAMES) {
+                noise[k] += power / WARMUP_FRAMES;
+            } else if (smoothed[k] < noise[k]) {
+                noise[k] = NOISE_FALL * noise[k] + (1.0f - NOISE_FALL) * smoothed[k];
+            } else {
+                noise[k] = std::min(noise[k] * NOISE_RISE, smoothed[k]);
+            }
+
+            float n = std::max(noise[k] * MINIMUM_BIAS, 1e-3f);
+            float posterior = power / n;
+            float prior = DD_ALPHA * prevGain[k] * prevGain[k] * prevPower[k] / n +
+                          (1.0f - DD_ALPHA) * std::max(posterior - 1.0f, 0.0f);
+            float gain = std::max(prior / (1.0f + prior), gainFloor);
+            if (framesSeen < WARMUP_FRAMES) gain = 1.0f;
+
+            prevGain[k] = gain;
+            prevPower[k] = power;
+
+            re[k] *= gain;
+            im[k] *= gain;
+            if (k > 0 && k < FRAME / 2) {
+                re[FRAME - k] = re[k];
+                im[FRAME - k] = -im[k];
+            }
+        }
+        framesSeen++;
+
+        fft.inverse(re.data(), im.data());
+
+        // Overlap-add: first half completes the previous frame's tail
+        const float scale = 1.0f / FRAME;
+        for (size_t i = 0; i < FRAME; i++) {
+            overlap[i] += re[i] * scale * window[i];
+        }
+        for (size_t i = 0; i < HOP; i++) {
+            output[(outputWrite + i) % output.size()] = overlap[i];
+        }
+        outputWrite = (outputWrite + HOP) % output.size();
+        std::copy(overlap.begin() + HOP, overlap.end(), overlap.begin());
+        std::fill(overlap.begin() + HOP, overlap.end(), 0.0f);
+
+        busyMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        frames++;
+    }
+};
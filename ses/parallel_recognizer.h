@@ -0,0 +1,365 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "endpointer.h"
+#include "nbest.h"
+#include "recorder_settings.h"
+#include "sample_span.h"
+#include "task_scheduler.h"
+#include "vosk-linux-x86_64-0.3.45/vosk_api.h"
+
+// Mean word confidence and text of one lane's view of an utterance.
+struct LaneResult {
+    uint64_t utterance = 0;
+    std::string text;
+    double confidenceSum = 0.0;
+    size_t words = 0;
+
+    double confidence() const { return words ? confidenceSum / words : 0.0; }
+};
+
+// One recognizer whose decode steps run on the shared scheduler, one at a
+// time, through its own strand. Audio and utterance-end markers are posted
+// by the capture thread; the lane turns each marker into a LaneResult
+// covering everything since the previous one.
+class RecognizerLane {
+public:
+    ~RecognizerLane() {
+        stop();
+    }
+
+    bool start(TaskScheduler& scheduler, VoskModel* model, int sampleRate, const std::string& laneLanguage) {
+        recognizer = vosk_recognizer_new(model, static_cast<float>(sampleRate));
+        if (!recognizer) return false;
+        vosk_recognizer_set_words(recognizer, 1);
+        language = laneLanguage;
+        strand = std::make_unique<Strand>(scheduler);
+        results.clear();   // a lane dropped by an early decision leaves these behind
+        busySeconds = 0.0;
+        current = LaneResult();
+        return true;
+    }
+
+    bool running() const { return recognizer != nullptr; }
+    const std::string& lang() const { return language; }
+    double busy() const { return busySeconds; }
+
+    void push(const float* data, size_t count) {
+        if (count == 0) return;
+        std::vector<float> samples;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!spare.empty()) {
+                samples.swap(spare.back());
+                spare.pop_back();
+            }
+        }
+        samples.assign(data, data + count);
+        strand->post([this, samples = std::move(samples)]() mutable {
+            auto begin = std::chrono::steady_clock::now();
+            if (vosk_recognizer_accept_waveform_f(recognizer, samples.data(), static_cast<int>(samples.size()))) {
+                add(vosk_recognizer_result(recognizer));
+            }
+            busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            std::lock_guard<std::mutex> lock(mutex);
+            spare.push_back(std::move(samples));
+        });
+    }
+
+    void finalize(uint64_t utterance) {
+        strand->post([this, utterance] {
+            auto begin = std::chrono::steady_clock::now();
+            add(vosk_recognizer_final_result(recognizer));
+            current.utterance = utterance;
+            busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(std::move(current));
+            current = LaneResult();
+        });
+    }
+
+    bool poll(LaneResult& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (results.empty()) return false;
+        out = std::move(results.front());
+        results.pop_front();
+        return true;
+    }
+
+    // Drains queued audio and markers, then frees the recognizer.
+    void stop() {
+        if (strand) {
+            strand->drain();
+            strand.reset();
+        }
+        if (recognizer) {
+            vosk_recognizer_free(recognizer);
+            recognizer = nullptr;
+        }
+    }
+
+    // Drops queued audio and stops without finishing the current utterance.
+    void abandon() {
+        if (strand) strand->clear();
+        stop();
+    }
+
+private:
+    VoskRecognizer* recognizer = nullptr;
+    std::string language;
+    std::unique_ptr<Strand> strand;
+    std::mutex mutex;
+    std::vector<std::vector<float>> spare;     // recycled sample buffers
+    std::deque<LaneResult> results;
+    double busySeconds = 0.0;                  // strand only until stop()
+    LaneResult current;                        // strand only
+    std::vector<Hypothesis> hypotheses;
+
+    void add(const char* json) {
+        if (ResultParser::parse(json, hypotheses) == 0) return;
+        current.text += (current.text.empty() ? "" : " ") + hypotheses[0].text;
+        ResultParser::wordConfidences(json, current.confidenceSum, current.words);
+    }
+};
+
+// Two recognizers with different models on the same VAD-gated audio.
+//
+// The capture thread runs an Endpointer over the feed; audio is only passed
+// to the lanes while an utterance is open (plus a short lookback so the
+// onset is not clipped), and each utterance end becomes a marker on both
+// lanes, so both decode exactly the same span. When both results for an
+// utterance are in, the one with the higher mean word confidence wins.
+//
+// With parallel-decide-seconds set, the lane with the lower average
+// confidence over that much speech is stopped and the rest of the session
+// runs on the winner alone.
+class ParallelRecognition {
+public:
+    ~ParallelRecognition() {
+        for (auto& lane : lanes) lane.stop();
+        if (secondModel) vosk_model_free(secondModel);
+    }
+
+    bool start(const RecorderSettings& settings, VoskModel* primary, int rate, TaskScheduler& scheduler) {
+        if (settings.parallelModel.empty() || !primary) return false;
+        if (!secondModel || loadedPath != settings.parallelModel) {
+            if (secondModel) vosk_model_free(secondModel);
+            std::cout << "🌐 Loading second model: " << settings.parallelModel << std::endl;
+            secondModel = vosk_model_new(settings.parallelModel.c_str());
+            loadedPath = settings.parallelModel;
+            if (!secondModel) {
+                std::cerr << "❌ Second model could not be loaded, parallel recognition off" << std::endl;
+                return false;
+            }
+        }
+
+        sampleRate = rate;
+        RecorderSettings laneSettings = settings;
+        if (laneSettings.endpointSilenceMs <= 0) {
+            laneSettings.endpointSilenceMs = DEFAULT_SILENCE_MS;   // lanes need a shared utterance end
+        }
+        endpointer.configure(laneSettings, rate);
+        decideSamples = static_cast<uint64_t>(settings.parallelDecideSeconds * rate);
+        lookback.assign(static_cast<size_t>(rate) * LOOKBACK_MS / 1000, 0.0f);
+        lookbackFill = 0;
+        lookbackPos = 0;
+        nextUtterance = 0;
+        speechSamples = 0;
+        decided = false;
+        pending.clear();
+
+        const std::string languages[2] = {settings.textLanguage, settings.parallelLanguage};
+        VoskModel* models[2] = {primary, secondModel};
+        for (int i = 0; i < 2; i++) {
+            stats[i] = Stats();
+            if (!lanes[i].start(scheduler, models[i], rate, languages[i])) {
+                std::cerr << "❌ Recognizer for " << languages[i] << " could not be created" << std::endl;
+                for (auto& lane : lanes) lane.stop();
+                return false;
+            }
+        }
+        active = true;
+        std::cout << "🌐 Parallel recognition: " << languages[0] << " + " << languages[1] << std::endl;
+        return true;
+    }
+
+    bool running() const { return active; }
+
+    template <typename T>
+    void feed(SampleSpan<T> samples) {
+        if (work.size() < samples.size) work.resize(samples.size);
+        for (size_t i = 0; i < samples.size; i++) work[i] = samples.data[i];
+
+        endpointer.update(samples);
+        if (endpointer.inUtterance()) {
+            flushLookback();
+            for (auto& lane : lanes) {
+                if (lane.running()) lane.push(work.data(), samples.size);
+            }
+            speechSamples += samples.size;
+        } else {
+            remember(work.data(), samples.size);
+        }
+
+        Endpointer::Reason reason = endpointer.check();
+        if (reason != Endpointer::Reason::None) {
+            endUtterance();
+            endpointer.finalized(reason);
+        }
+    }
+
+    // Emits `emit(text, language, range)` for every utterance both lanes
+    // finished; `range` is where the utterance lies in the stream.
+    template <typename Emit>
+    void poll(Emit&& emit) {
+        for (int i = 0; i < 2; i++) {
+            LaneResult result;
+            while (lanes[i].poll(result)) {
+                Pending& entry = pending[result.utterance];
+                entry.results[i] = std::move(result);
+                entry.received |= 1 << i;
+            }
+        }
+        while (!pending.empty()) {
+            auto it = pending.begin();
+            if ((it->second.received & it->second.expected) != it->second.expected) break;
+            decide(it->second, emit);
+            pending.erase(it);
+        }
+        if (!decided && decideSamples > 0 && speechSamples >= decideSamples) {
+            earlyDecision();
+        }
+    }
+
+    template <typename Emit>
+    void finish(Emit&& emit) {
+        if (!active) return;
+        if (endpointer.inUtterance()) {
+            endUtterance();
+            endpointer.finalized(Endpointer::Reason::SessionEnd);
+        }
+        for (auto& lane : lanes) lane.stop();
+        poll(emit);
+        active = false;
+        endpointer.report();
+        report();
+    }
+
+private:
+    static constexpr int DEFAULT_SILENCE_MS = 600;
+    static constexpr int LOOKBACK_MS = 300;
+
+    struct Stats {
+        uint64_t wins = 0;
+        double confidenceSum = 0.0;
+        uint64_t utterances = 0;
+    };
+
+    struct Pending {
+        LaneResult results[2];
+        StreamRange range;
+        int received = 0;
+        int expected = 0;
+    };
+
+    RecognizerLane lanes[2];
+    VoskModel* secondModel = nullptr;
+    std::string loadedPath;
+    Endpointer endpointer;
+    std::vector<float> work;
+    std::vector<float> lookback;
+    size_t lookbackFill = 0;
+    size_t lookbackPos = 0;
+    std::map<uint64_t, Pending> pending;
+    uint64_t nextUtterance = 0;
+    uint64_t speechSamples = 0;
+    uint64_t decideSamples = 0;
+    Stats stats[2];
+    int sampleRate = 16000;
+    bool decided = false;
+    bool active = false;
+
+    void remember(const float* data, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            lookback[lookbackPos] = data[i];
+            lookbackPos = (lookbackPos + 1) % lookback.size();
+        }
+        lookbackFill = std::min(lookbackFill + count, lookback.size());
+    }
+
+    void flushLookback() {
+        if (lookbackFill == 0) return;
+        size_t start = (lookbackPos + lookback.size() - lookbackFill) % lookback.size();
+        size_t first = std::min(lookbackFill, lookback.size() - start);
+        for (auto& lane : lanes) {
+            if (!lane.running()) continue;
+            lane.push(&lookback[start], first);
+            lane.push(&lookback[0], lookbackFill - first);
+        }
+        lookbackFill = 0;
+    }
+
+    void endUtterance() {
+        Pending& entry = pending[nextUtterance];
+        entry.range = endpointer.utteranceRange();
+        for (int i = 0; i < 2; i++) {
+            if (lanes[i].running()) {
+                lanes[i].finalize(nextUtterance);
+                entry.expected |= 1 << i;
+            }
+        }
+        nextUtterance++;
+    }
+
+    template <typename Emit>
+    void decide(const Pending& entry, Emit&& emit) {
+        int winner = -1;
+        for (int i = 0; i < 2; i++) {
+            if (!(entry.expected & (1 << i))) continue;
+            const LaneResult& result = entry.results[i];
+            if (result.text.empty()) continue;
+            stats[i].confidenceSum += result.confidence();
+            stats[i].utterances++;
+            if (winner < 0 || result.confidence() > entry.results[winner].confidence()) {
+                winner = i;
+            }
+        }
+        if (winner < 0) return;
+        stats[winner].wins++;
+        emit(entry.results[winner].text, lanes[winner].lang(), entry.range);
+    }
+
+    void earlyDecision() {
+        decided = true;
+        double average[2];
+        for (int i = 0; i < 2; i++) {
+            average[i] = stats[i].utterances ? stats[i].confidenceSum / stats[i].utterances : 0.0;
+        }
+        int loser = average[0] >= average[1] ? 1 : 0;
+        std::cout << "\n🌐 Early decision after " << speechSamples / sampleRate << "s of speech: "
+                  << lanes[1 - loser].lang() << " (" << average[1 - loser] << " vs " << average[loser]
+                  << "), stopping " << lanes[loser].lang() << std::endl;
+        lanes[loser].abandon();
+        // Utterances still in flight only wait for the remaining lane now
+        for (auto& [id, entry] : pending) {
+            entry.expected &= ~(1 << loser);
+        }
+    }
+
+    void report() const {
+        for (int i = 0; i < 2; i++) {
+            std::cout << "🌐 " << lanes[i].lang() << ": won " << stats[i].wins << " of "
+                      << nextUtterance << " utterances, mean confidence "
+                      << (stats[i].utterances ? stats[i].confidenceSum / stats[i].utterances : 0.0)
+                      << ", decode " << lanes[i].busy() << "s CPU" << std::endl;
+        }
+    }
+};
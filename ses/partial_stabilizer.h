@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "recorder_settings.h"
+
+// Splits the open utterance's partial into a committed prefix and a
+// tentative tail. A word is committed once it has survived
+// `stable-updates` hypothesis changes, or has stood unchanged for
+// `stable-ms` of audio; the last word of a partial never is, since more
+// audio can still extend it. Committed words are not taken back: when the
+// decoder later revises one, the committed words are kept and only the
+// hypothesis after them is shown (counted as a retraction). The final
+// result replaces the whole utterance regardless.
+class PartialStabilizer {
+public:
+    void configure(const RecorderSettings& settings) {
+        stableUpdates = settings.stableUpdates;
+        stableMs = settings.stableMs;
+        reset();
+        committedWords = retractions = totalLagMs = 0;
+    }
+
+    // Next utterance.
+    void reset() {
+        words.clear();
+        shown.clear();
+        committed = 0;
+    }
+
+    // Text to show for `hypothesis` at stream time `nowMs`. Its first
+    // `heldBytes` bytes are model finals already in the utterance and are
+    // committed as they are. `committedBytes` receives the length of the
+    // committed prefix of the returned text.
+    std::string_view update(std::string_view hypothesis, size_t heldBytes, double nowMs, size_t& committedBytes) {
+        // Committed words stay; the hypothesis supplies what follows them
+        std::string_view rest = hypothesis;
+        size_t keepWords = 0;
+        for (; keepWords < committed; keepWords++) {
+            std::string_view word = nextWord(rest);
+            if (word.empty()) break;
+            if (word != wordAt(keepWords)) {
+                retractions++;
+                rest = skipWords(hypothesis, committed);
+                keepWords = committed;
+                break;
+            }
+        }
+        candidate.assign(shown, 0, committed > 0 ? words[committed - 1].end : 0);
+        while (!rest.empty() && rest.front() == ' ') rest.remove_prefix(1);
+        if (!rest.empty()) {
+            if (!candidate.empty()) candidate += ' ';
+            candidate += rest;
+        }
+
+        if (candidate != shown) {
+            // Words up to the first difference live on; the rest start over
+            size_t same = 0;
+            std::string_view newText = candidate;
+            size_t offset = 0;
+            size_t index = 0;
+            while (true) {
+                size_t begin = offset;
+                while (begin < newText.size() && newText[begin] == ' ') begin++;
+                if (begin >= newText.size()) break;
+                size_t end = newText.find(' ', begin);
+                if (end == std::string_view::npos) end = newText.size();
+                std::string_view word = newText.substr(begin, end - begin);
+                bool unchanged = index == same && index < words.size() && word == wordAt(index);
+                if (unchanged) {
+                    same++;
+                    words[index].begin = begin;
+                    words[index].end = end;
+                    words[index].survived++;
+                } else if (index < words.size()) {
+                    words[index] = {begin, end, 0, nowMs};
+                } else {
+                    words.push_back({begin, end, 0, nowMs});
+                }
+                offset = end;
+                index++;
+            }
+            words.resize(index);
+            shown.swap(candidate);
+        }
+
+        // Held finals are committed outright; then stable words in order
+        while (committed < words.size() && words[committed].end <= heldBytes) commit(nowMs);
+        while (committed + 1 < words.size() &&
+               (words[committed].survived >= static_cast<uint32_t>(stableUpdates) ||
+                nowMs - words[committed].since >= stableMs)) {
+            commit(nowMs);
+        }
+        committedBytes = committed > 0 ? words[committed - 1].end : 0;
+        return shown;
+    }
+
+    void report() const {
+        if (committedWords == 0) return;
+        std::cout << "🧊 Stabilization: " << committedWords << " words committed before their final, "
+                  << (totalLagMs / committedWords) << " ms after first shown on average, " << retractions
+                  << " revised by the decoder afterwards" << std::endl;
+    }
+
+private:
+    struct Word {
+        size_t begin;
+        size_t end;
+        uint32_t survived;                // hypothesis changes it has lived through
+        double since;                     // stream time it first appeared, ms
+    };
+
+    int stableUpdates = 3;
+    int stableMs = 600;
+    std::vector<Word> words;              // of `shown`
+    std::string shown;
+    std::string candidate;                // scratch, kept for its capacity
+    size_t committed = 0;                 // leading words of `shown` that are committed
+    uint64_t committedWords = 0;
+    uint64_t retractions = 0;
+    double totalLagMs = 0.0;
+
+    std::string_view wordAt(size_t index) const {
+        return std::string_view(shown).substr(words[index].begin, words[index].end - words[index].begin);
+    }
+
+    void commit(double nowMs) {
+        totalLagMs += nowMs - words[committed].since;
+        committedWords++;
+        committed++;
+    }
+
+    // Takes the next space-separated word off the front of `text`.
+    static std::string_view nextWord(std::string_view& text) {
+        while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+        size_t end = text.find(' ');
+        if (end == std::string_view::npos) end = text.size();
+        std::string_view word = text.substr(0, end);
+        text.remove_prefix(end);
+        return word;
+    }
+
+    static std::string_view skipWords(std::string_view text, size_t count) {
+        for (size_t i = 0; i < count && !text.empty(); i++) nextWord(text);
+        return text;
+    }
+};
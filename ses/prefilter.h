@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "recorder_settings.h"
+#include "sample_span.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Cascade of up to four biquads (transposed direct form II) run as one SIMD
+// pipeline: lane k holds section k, and each step feeds lane k with what
+// lane k-1 produced on the previous step. One sample goes through all four
+// sections per step at the cost of a single section, in exchange for a
+// fixed SECTIONS-1 sample delay. Unused lanes are identity sections.
+class BiquadCascade {
+public:
+    static constexpr size_t SECTIONS = 4;
+    static constexpr size_t DELAY = SECTIONS - 1;
+
+    struct Coefficients {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    };
+
+    void setSection(size_t k, const Coefficients& c) {
+        b0[k] = c.b0;
+        b1[k] = c.b1;
+        b2[k] = c.b2;
+        a1[k] = c.a1;
+        a2[k] = c.a2;
+    }
+
+    void clearSections() {
+        for (size_t k = 0; k < SECTIONS; k++) setSection(k, Coefficients());
+    }
+
+    void reset() {
+        for (size_t k = 0; k < SECTIONS; k++) {
+            s1[k] = 0.0f;
+            s2[k] = 0.0f;
+            pipe[k] = 0.0f;
+        }
+    }
+
+    // First-order DC blocker y = x - x[-1] + r*y[-1], corner ~ (1-r)*rate/2pi
+    static Coefficients dcBlocker(double cornerHz, int rate) {
+        Coefficients c;
+        double r = 1.0 - 2.0 * M_PI * cornerHz / rate;
+        c.b1 = -1.0f;
+        c.a1 = static_cast<float>(-r);
+        return c;
+    }
+
+    // RBJ cookbook high-pass
+    static Coefficients highPass(double cornerHz, double q, int rate) {
+        double w = 2.0 * M_PI * cornerHz / rate;
+        double alpha = std::sin(w) / (2.0 * q);
+        double cosw = std::cos(w);
+        double a0 = 1.0 + alpha;
+        Coefficients c;
+        c.b0 = static_cast<float>((1.0 + cosw) / 2.0 / a0);
+        c.b1 = static_cast<float>(-(1.0 + cosw) / a0);
+        c.b2 = c.b0;
+        c.a1 = static_cast<float>(-2.0 * cosw / a0);
+        c.a2 = static_cast<float>((1.0 - alpha) / a0);
+        return c;
+    }
+
+    // In place; samples[i] receives the cascade output for input i - DELAY.
+    void process(float* samples, size_t count) {
+#if defined(__SSE2__)
+        const __m128 vb0 = _mm_loadu_ps(b0), vb1 = _mm_loadu_ps(b1), vb2 = _mm_loadu_ps(b2);
+        const __m128 va1 = _mm_loadu_ps(a1), va2 = _mm_loadu_ps(a2);
+        __m128 vs1 = _mm_loadu_ps(s1), vs2 = _mm_loadu_ps(s2);
+        __m128 in = _mm_loadu_ps(pipe);
+        for (size_t i = 0; i < count; i++) {
+            in = _mm_move_ss(in, _mm_set_ss(samples[i]));
+            __m128 out = _mm_add_ps(_mm_mul_ps(vb0, in), vs1);
+            vs1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(vb1, in), _mm_mul_ps(va1, out)), vs2);
+            vs2 = _mm_sub_ps(_mm_mul_ps(vb2, in), _mm_mul_ps(va2, out));
+            samples[i] = _mm_cvtss_f32(_mm_shuffle_ps(out, out, _MM_SHUFFLE(3, 3, 3, 3)));
+            // Lane k's output becomes lane k+1's next input
+            in = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(out), 4));
+        }
+        _mm_storeu_ps(s1, vs1);
+        _mm_storeu_ps(s2, vs2);
+        _mm_storeu_ps(pipe, in);
+#else
+        for (size_t i = 0; i < count; i++) {
+            pipe[0] = samples[i];
+            float out[SECTIONS];
+            for (size_t k = 0; k < SECTIONS; k++) {
+                out[k] = b0[k] * pipe[k] + s1[k];
+                s1[k] = b1[k] * pipe[k] - a1[k] * out[k] + s2[k];
+                s2[k] = b2[k] * pipe[k] - a2[k] * out[k];
+            }
+            samples[i] = out[SECTIONS - 1];
+            for (size_t k = 1; k < SECTIONS; k++) pipe[k] = out[k - 1];
+        }
+#endif
+    }
+
+private:
+    float b0[SECTIONS] = {1, 1, 1, 1};
+    float b1[SECTIONS] = {};
+    float b2[SECTIONS] = {};
+    float a1[SECTIONS] = {};
+    float a2[SECTIONS] = {};
+    float s1[SECTIONS] = {};
+    float s2[SECTIONS] = {};
+    float pipe[SECTIONS] = {};
+};
+
+// Capture prefilter: DC blocker plus an optional 4th-order Butterworth
+// high-pass, enabled per source (microphone / system monitor). Runs on the
+// capture span before the level meter, archive and recognizer.
+class Prefilter {
+public:
+    void configure(const RecorderSettings& settings, int captureMode, int sampleRate, size_t maxSamples) {
+        mode = captureMode;
+        rate = sampleRate;
+        work.allocate(maxSamples);
+        cascade.reset();
+        applySettings(settings);
+    }
+
+    void applySettings(const RecorderSettings& settings) {
+        bool wanted = mode == 2 ? settings.prefilterMonitor : settings.prefilterMicrophone;
+        if (wanted && !enabled) {
+            cascade.reset();
+        }
+        enabled = wanted;
+
+        cascade.clearSections();
+        cascade.setSection(0, BiquadCascade::dcBlocker(DC_CORNER_HZ, rate));
+        if (settings.highPassHz > 0) {
+            // Butterworth pole pair Qs for 4th order
+            cascade.setSection(1, BiquadCascade::highPass(settings.highPassHz, 0.5412, rate));
+            cascade.setSection(2, BiquadCascade::highPass(settings.highPassHz, 1.3066, rate));
+        }
+    }
+
+    bool active() const { return enabled; }
+
+    FloatSpan process(Int16Span samples) {
+        if (samples.size > work.capacity()) {
+            work.allocate(samples.size);
+        }
+        float* out = work.data();
+        for (size_t i = 0; i < samples.size; i++) {
+            out[i] = samples.data[i];
+        }
+        return process(FloatSpan{out, samples.size});
+    }
+
+    FloatSpan process(FloatSpan samples) {
+        cascade.process(samples.data, samples.size);
+        return samples;
+    }
+
+private:
+    static constexpr double DC_CORNER_HZ = 5.0;
+
+    BiquadCascade cascade;
+    AlignedBuffer<float> work;
+    int mode = 1;
+    int rate = 16000;
+    bool enabled = false;
+};
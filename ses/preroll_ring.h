@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Fixed-size ring holding the last few seconds of capture while the daemon is
+// idle, so speech that started just before recording was triggered still
+// reaches the recognizer.
+//
+// Audio is kept in 20 ms frames with a per-frame mean absolute level. With
+// VAD gating enabled, drain() skips leading silence and starts a few frames
+// before the first voiced frame instead of replaying the whole ring.
+//
+// Cost of keeping the ring hot: one memcpy of the incoming chunk plus a
+// running abs-sum per sample (~32 KB/s at 16 kHz); the measured time is
+// reported by cpuMicrosPerSecond().
+class PreRollRing {
+public:
+    static constexpr size_t VAD_MARGIN_FRAMES = 10;   // 200 ms lead-in before speech
+
+    void configure(size_t seconds, int sampleRate, bool vadGated) {
+        frameSamples = static_cast<size_t>(sampleRate) / 50;
+        frameCount = std::max<size_t>(1, seconds * 50);
+        samples.assign(frameCount * frameSamples, 0);
+        levels.assign(frameCount, 0);
+        this->sampleRate = sampleRate;
+        this->vadGated = vadGated;
+        noiseFloor = -1.0;
+        clear();
+    }
+
+    void clear() {
+        writeFrame = 0;
+        storedFrames = 0;
+        partial = 0;
+        partialSum = 0;
+    }
+
+    template <typename T>
+    void write(const T* data, size_t count) {
+        if (frameCount == 0) return;
+        auto begin = std::chrono::steady_clock::now();
+
+        while (count > 0) {
+            int16_t* frame = &samples[writeFrame * frameSamples];
+            size_t take = std::min(count, frameSamples - partial);
+            for (size_t i = 0; i < take; i++) {
+                int16_t sample = toInt16(data[i]);
+                frame[partial + i] = sample;
+                partialSum += std::abs(sample);
+            }
+            partial += take;
+            data += take;
+            count -= take;
+
+            if (partial == frameSamples) {
+                commitFrame();
+            }
+        }
+
+        busyMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    // Hands the buffered audio, oldest first, to `sink(const int16_t*, size_t)`
+    // and empties the ring.
+    template <typename Sink>
+    size_t drain(Sink sink) {
+        size_t first = storedFrames < frameCount ? 0 : writeFrame;
+        size_t available = storedFrames;
+        if (storedFrames == frameCount && partial > 0) {
+            // The frame being filled has already overwritten the oldest one
+            first = (writeFrame + 1) % frameCount;
+            available--;
+        }
+        size_t skip = 0;
+
+        if (vadGated) {
+            skip = available;
+            for (size_t i = 0; i < available; i++) {
+                if (isVoiced(levels[(first + i) % frameCount])) {
+                    skip = i > VAD_MARGIN_FRAMES ? i - VAD_MARGIN_FRAMES : 0;
+                    break;
+                }
+            }
+        }
+
+        size_t drained = 0;
+        for (size_t i = skip; i < available; i++) {
+            size_t index = (first + i) % frameCount;
+            sink(&samples[index * frameSamples], frameSamples);
+            drained += frameSamples;
+        }
+        if (partial > 0) {
+            sink(&samples[writeFrame * frameSamples], partial);
+            drained += partial;
+        }
+        clear();
+        return drained;
+    }
+
+    double seconds() const {
+        return static_cast<double>(frameCount * frameSamples) / sampleRate;
+    }
+
+    // Time spent maintaining the ring per second of audio that went through it.
+    double cpuMicrosPerSecond() const {
+        double audioSeconds = static_cast<double>(framesSeen * frameSamples) / sampleRate;
+        return audioSeconds > 0 ? busyMicros / audioSeconds : 0.0;
+    }
+
+private:
+    std::vector<int16_t> samples;
+    std::vector<uint32_t> levels;      // mean |x| per frame
+    size_t frameSamples = 320;         // 20 ms at 16 kHz
+    size_t frameCount = 0;
+    size_t writeFrame = 0;
+    size_t storedFrames = 0;
+    size_t partial = 0;
+    uint64_t partialSum = 0;
+    int sampleRate = 16000;
+    bool vadGated = false;
+    double noiseFloor = -1.0;
+    uint64_t framesSeen = 0;
+    double busyMicros = 0.0;
+
+    static int16_t toInt16(int16_t sample) { return sample; }
+
+    static int16_t toInt16(float sample) {
+        sample = sample > 32767.0f ? 32767.0f : (sample < -32768.0f ? -32768.0f : sample);
+        return static_cast<int16_t>(sample);
+    }
+
+    void commitFrame() {
+        uint32_t level = static_cast<uint32_t>(partialSum / frameSamples);
+        levels[writeFrame] = level;
+
+        // Slow-rising, fast-falling noise floor estimate for the VAD
+        if (noiseFloor < 0) {
+            noiseFloor = level;
+        } else if (level < noiseFloor) {
+            noiseFloor = 0.9 * noiseFloor + 0.1 * level;
+        } else {
+            noiseFloor = 0.999 * noiseFloor + 0.001 * level;
+        }
+
+        writeFrame = (writeFrame + 1) % frameCount;
+        if (storedFrames < frameCount) storedFrames++;
+        partial = 0;
+        partialSum = 0;
+        framesSeen++;
+    }
+
+    bool isVoiced(uint32_t level) const {
+        return level > 300 && level > 3.0 * noiseFloor;
+    }
+};
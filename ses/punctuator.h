@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Rule-based punctuation and truecasing for final segments (one recognizer
+// utterance = one sentence). Handles English and Turkish:
+//   - capitalize the first letter, with Turkish dotted/dotless i
+//   - end with '?' for question words / Turkish question particles, else '.';
+//     an English auxiliary only counts when a subject follows ("do you")
+//   - comma before contrastive conjunctions and after leading interjections
+//   - English "i" and its contractions, weekdays, months and languages
+// Text that already ends in punctuation (e.g. from the vocabulary) keeps it.
+class Punctuator {
+public:
+    // Full rules, or capitalization only (the fast path under a deadline).
+    void process(std::string& text, const std::string& language, bool full = true) const {
+        if (text.empty()) return;
+        const Rules& rules = language.compare(0, 2, "tr") == 0 ? turkish() : english();
+
+        if (full) {
+            words.clear();
+            splitWords(text, words);
+            out.clear();
+            for (size_t i = 0; i < words.size(); i++) {
+                std::string& word = words[i];
+                if (i > 0 && rules.commaBefore.count(word) && i >= 3 && !endsWithPunctuation(out)) {
+                    out += ',';
+                }
+                if (i > 0) out += ' ';
+                appendTruecased(out, word, rules);
+                if (rules.englishI) fixEnglishI(out, word);
+                if (i == 0 && words.size() > 2 && rules.commaAfterFirst.count(word)) {
+                    out += ',';
+                }
+            }
+            if (!endsWithPunctuation(out)) {
+                out += isQuestion(words, rules) ? '?' : '.';
+            }
+            text.swap(out);
+        }
+        capitalizeFirst(text, rules.turkishCasing);
+    }
+
+private:
+    struct Rules {
+        std::unordered_set<std::string> questionStart;     // question if the first word is one of these
+        std::unordered_set<std::string> questionAuxiliary; // ...or this one, followed by a subject
+        std::unordered_set<std::string> subjects;          // personal pronouns
+        std::unordered_set<std::string> thingSubjects;     // it, this, ...: subjects unless after an imperative
+        std::unordered_set<std::string> imperatives;       // auxiliaries that are also imperative verbs
+        std::unordered_set<std::string> questionAnywhere;  // question if any word is one of these
+        std::unordered_set<std::string> commaBefore;
+        std::unordered_set<std::string> commaAfterFirst;
+        std::unordered_map<std::string, std::string> truecase;   // recognizer form -> written form
+        bool englishI = false;
+        bool turkishCasing = false;
+    };
+
+    mutable std::vector<std::string> words;    // scratch, worker thread only
+    mutable std::string out;
+
+    static bool endsWithPunctuation(const std::string& text) {
+        return !text.empty() && std::strchr(".?!,;:", text.back()) != nullptr;
+    }
+
+    static void splitWords(const std::string& text, std::vector<std::string>& words) {
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find(' ', start);
+            if (end == std::string::npos) end = text.size();
+            if (end > start) words.emplace_back(text, start, end - start);
+            start = end + 1;
+        }
+    }
+
+    static bool isQuestion(const std::vector<std::string>& words, const Rules& rules) {
+        if (words.empty()) return false;
+        if (rules.questionStart.count(words[0])) return true;
+        if (words.size() > 1 && rules.questionAuxiliary.count(words[0])) {
+            if (rules.subjects.count(words[1])) return true;
+            // "do it now", "have that ready": the object of an imperative
+            if (rules.thingSubjects.count(words[1]) && !rules.imperatives.count(words[0])) return true;
+        }
+        for (const std::string& word : words) {
+            if (rules.questionAnywhere.count(word)) return true;
+        }
+        return false;
+    }
+
+    // Known proper nouns, also with a Turkish case suffix ("istanbul'a")
+    static void appendTruecased(std::string& out, const std::string& word, const Rules& rules) {
+        auto cased = rules.truecase.find(word);
+        if (cased != rules.truecase.end()) {
+            out += cased->second;
+            return;
+        }
+        size_t apostrophe = word.find('\'');
+        if (apostrophe != std::string::npos && rules.turkishCasing) {
+            cased = rules.truecase.find(word.substr(0, apostrophe));
+            if (cased != rules.truecase.end()) {
+                out += cased->second;
+                out.append(word, apostrophe, std::string::npos);
+                return;
+            }
+        }
+        out += word;
+    }
+
+    // "i", "i'm", "i've", ... as the word just appended to `out`
+    static void fixEnglishI(std::string& out, const std::string& word) {
+        if (word == "i" || word.compare(0, 2, "i'") == 0) {
+            out[out.size() - word.size()] = 'I';
+        }
+    }
+
+    static void capitalizeFirst(std::string& text, bool turkishCasing) {
+        unsigned char c = text[0];
+        if (c < 0x80) {
+            if (turkishCasing && c == 'i') {
+                text.replace(0, 1, "\xC4\xB0");              // İ
+            } else {
+                text[0] = static_cast<char>(std::toupper(c));
+            }
+            return;
+        }
+        if (text.size() < 2) return;
+        // Two-byte lowercase letters used by Turkish and most Latin-1 text
+        static const char* const pairs[][2] = {
+            {"\xC4\xB1", "I"},             // ı -> I
+            {"\xC3\xA7", "\xC3\x87"},      // ç
+            {"\xC4\x9F", "\xC4\x9E"},      // ğ
+            {"\xC3\xB6", "\xC3\x96"},      // ö
+            {"\xC5\x9F", "\xC5\x9E"},      // ş
+            {"\xC3\xBC", "\xC3\x9C"},      // ü
+        };
+        for (const auto& pair : pairs) {
+            if (text.compare(0, 2, pair[0]) == 0) {
+                text.replace(0, 2, pair[1]);
+                return;
+            }
+        }
+    }
+
+    static Rules build(std::initializer_list<const char*> questionStart,
+                       std::initializer_list<const char*> questionAnywhere,
+                       std::initializer_list<const char*> commaBefore,
+                       std::initializer_list<const char*> commaAfterFirst,
+                       std::initializer_list<std::pair<const char*, const char*>> truecase) {
+        Rules rules;
+        for (const char* w : questionStart) rules.questionStart.insert(w);
+        for (const char* w : questionAnywhere) rules.questionAnywhere.insert(w);
+        for (const char* w : commaBefore) rules.commaBefore.insert(w);
+        for (const char* w : commaAfterFirst) rules.commaAfterFirst.insert(w);
+        for (const auto& w : truecase) rules.truecase.emplace(w.first, w.second);
+        return rules;
+    }
+
+    static const Rules& english() {
+        static const Rules rules = [] {
+            Rules r = build(
+                {"what", "why", "how", "who", "whom", "whose", "where", "when", "which"},
+                {},
+                {"but", "however", "although", "though", "whereas"},
+                {"yes", "no", "well", "okay", "ok", "so", "oh", "hey", "please", "thanks"},
+                {{"monday", "Monday"}, {"tuesday", "Tuesday"}, {"wednesday", "Wednesday"},
+                 {"thursday", "Thursday"}, {"friday", "Friday"}, {"saturday", "Saturday"},
+                 {"sunday", "Sunday"}, {"january", "January"}, {"february", "February"},
+                 {"april", "April"}, {"june", "June"}, {"july", "July"}, {"august", "August"},
+                 {"september", "September"}, {"october", "October"}, {"november", "November"},
+                 {"december", "December"}, {"english", "English"}, {"turkish", "Turkish"},
+                 {"german", "German"}, {"french", "French"}, {"spanish", "Spanish"},
+                 {"italian", "Italian"}, {"russian", "Russian"}, {"chinese", "Chinese"},
+                 {"japanese", "Japanese"}, {"linux", "Linux"}, {"gnome", "GNOME"},
+                 {"google", "Google"}, {"ubuntu", "Ubuntu"}, {"fedora", "Fedora"}});
+            // "have a nice day", "do it now" and "will be there" are not questions
+            r.questionAuxiliary = {"is", "are", "am", "was", "were", "do", "does", "did", "can", "could",
+                                   "would", "will", "should", "shall", "may", "might", "have", "has", "had",
+                                   "isn't", "aren't", "wasn't", "weren't", "don't", "doesn't", "didn't",
+                                   "can't", "couldn't", "won't", "wouldn't", "shouldn't", "haven't", "hasn't"};
+            r.subjects = {"i", "you", "he", "she", "we", "they"};
+            r.thingSubjects = {"it", "this", "that", "there"};
+            r.imperatives = {"do", "have"};
+            r.englishI = true;
+            return r;
+        }();
+        return rules;
+    }
+
+    static const Rules& turkish() {
+        static const Rules rules = [] {
+            Rules r = build(
+                {"ne", "neden", "niçin", "niye", "nasıl", "nerede", "nereye", "nereden", "kim", "kime",
+                 "hangi", "kaç"},
+                {"mi", "mı", "mu", "mü", "misin", "mısın", "musun", "müsün", "miyim", "mıyım", "muyum",
+                 "müyüm", "miyiz", "mıyız", "muyuz", "müyüz", "misiniz", "mısınız", "musunuz", "müsünüz",
+                 "midir", "mıdır", "mudur", "müdür", "mıydı", "miydi", "muydu", "müydü", "neden", "nasıl",
+                 "nerede", "niye"},
+                {"ama", "fakat", "ancak", "lakin", "yoksa"},
+                {"evet", "hayır", "tamam", "peki", "yani", "lütfen", "merhaba"},
+                {{"türkiye", "Türkiye"}, {"istanbul", "İstanbul"}, {"ankara", "Ankara"},
+                 {"izmir", "İzmir"}, {"türkçe", "Türkçe"}, {"ingilizce", "İngilizce"},
+                 {"almanca", "Almanca"}, {"fransızca", "Fransızca"}, {"linux", "Linux"},
+                 {"gnome", "GNOME"}, {"google", "Google"}, {"ubuntu", "Ubuntu"}});
+            r.turkishCasing = true;
+            return r;
+        }();
+        return rules;
+    }
+};
+
+// Runs the Punctuator on final segments off the capture thread.
+//
+// The worker takes everything queued (up to `maxBatch` segments) in one go,
+// so a burst of finals costs one wake-up. A segment that has already waited
+// longer than the deadline only gets capitalized, which bounds how far the
+// stage can fall behind. Results come back in submission order via poll(),
+// with the language they were submitted in.
+class PunctuationWorker {
+public:
+    ~PunctuationWorker() {
+        stop();
+    }
+
+    void start(double deadlineMs, size_t maxBatch) {
+        stop();
+        deadline = std::chrono::microseconds(static_cast<int64_t>(deadlineMs * 1000));
+        batchLimit = std::max<size_t>(1, maxBatch);
+        segments = 0;
+        batches = 0;
+        late = 0;
+        processMicrosTotal = 0.0;
+        processMicrosMax = 0.0;
+        waitMicrosMax = 0.0;
+        stopping = false;
+        running = true;
+        worker = std::thread(&PunctuationWorker::run, this);
+    }
+
+    bool active() const { return running; }
+
+    void submit(const std::string& text, const std::string& language) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back({text, language, std::chrono::steady_clock::now()});
+        }
+        wake.notify_one();
+    }
+
+    template <typename Emit>
+    void poll(Emit&& emit) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (done.empty()) return;
+            delivered.swap(done);   // both keep their storage, so polling does not allocate
+        }
+        for (const Segment& segment : delivered) {
+            emit(segment.text, segment.language);
+        }
+        delivered.clear();
+    }
+
+    // Finishes everything submitted so far, then stops the thread.
+    void stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+        running = false;
+    }
+
+    void report() const {
+        if (segments == 0) return;
+        std::cout << "✍️ Punctuation: " << segments << " segments in " << batches << " batches, "
+                  << (processMicrosTotal / segments) << "µs per segment (max " << processMicrosMax
+                  << "µs), max queue wait " << (waitMicrosMax / 1000.0) << " ms, " << late
+                  << " past the deadline" << std::endl;
+    }
+
+private:
+    struct Segment {
+        std::string text;
+        std::string language;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    Punctuator punctuator;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Segment> pending;
+    std::deque<Segment> done;
+    std::deque<Segment> delivered;   // poll() only
+    std::chrono::microseconds deadline{200000};
+    size_t batchLimit = 8;
+    bool stopping = false;
+    bool running = false;
+
+    uint64_t segments = 0;
+    uint64_t batches = 0;
+    uint64_t late = 0;
+    double processMicrosTotal = 0.0;
+    double processMicrosMax = 0.0;
+    double waitMicrosMax = 0.0;
+
+    void run() {
+        std::vector<Segment> batch;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) return;
+            batch.clear();
+            while (!pending.empty() && batch.size() < batchLimit) {
+                batch.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
+            lock.unlock();
+
+            for (Segment& segment : batch) {
+                auto begin = std::chrono::steady_clock::now();
+                bool inTime = begin - segment.submitted <= deadline;
+                punctuator.process(segment.text, segment.language, inTime);
+                auto end = std::chrono::steady_clock::now();
+
+                double processMicros = std::chrono::duration<double, std::micro>(end - begin).count();
+                double waitMicros = std::chrono::duration<double, std::micro>(begin - segment.submitted).count();
+                processMicrosTotal += processMicros;
+                processMicrosMax = std::max(processMicrosMax, processMicros);
+                waitMicrosMax = std::max(waitMicrosMax, waitMicros);
+                if (!inTime) late++;
+                segments++;
+            }
+            batches++;
+
+            lock.lock();
+            for (Segment& segment : batch) {
+                done.push_back(std::move(segment));
+            }
+        }
+    }
+};
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Backend tuning knobs, loaded from a simple key=value file next to the binary
+// (same place as current_model.txt). Unknown keys are reported and skipped so the
+// file can be shared between versions of the recorder.
+struct RecorderSettings {
+    // Archive
+    std::string archiveFormat = "flac";   // wav, flac, opus
+    int opusBitrateKbps = 24;
+    size_t archiveQueueBlocks = 64;       // 64 x 4096 samples ~ 16s at 16 kHz
+    int segmentSeconds = 60;              // 0 = one file per session
+    int fsyncSeconds = 5;                 // 0 = only when a segment closes
+
+    // File output (see async_writer.h)
+    std::string writerBackend = "io_uring";   // io_uring (threads when unavailable), threads
+    size_t writerBuffers = 8;             // fixed write buffers, at most one per open file
+    size_t writerBufferKb = 64;
+    int writerThreads = 2;                // threads backend
+    size_t writerQueueKb = 1024;          // queued output at which the archive encoder waits
+
+    // Capture format
+    bool captureNative = true;            // capture at the device rate, resample in-process
+    int resamplerTaps = 48;               // filter length at the model rate
+
+    // DSP
+    bool prefilterMicrophone = false;
+    bool prefilterMonitor = true;         // system audio often carries DC offset and rumble
+    float highPassHz = 80.0f;             // 0 leaves only the DC blocker
+    bool noiseReduction = true;
+    float noiseFloorDb = -20.0f;          // strongest attenuation applied to noise-only bins
+    bool agc = true;
+    int microphoneSensitivity = 50;       // 0-100, caps the AGC boost at 0..+40 dB
+    float agcTargetDb = -18.0f;           // target RMS level, dBFS
+    float agcAttackMs = 10.0f;
+    float agcReleaseMs = 400.0f;
+
+    // Endpointing (see endpointer.h); endpoint-profile sets all three
+    int endpointSilenceMs = 0;            // 0 = the model's own endpoints
+    float endpointMaxSeconds = 0.0f;      // 0 = no cap
+    float endpointVadLevel = 300.0f;      // minimum mean |sample| counted as speech
+
+    // Partial stabilization (see partial_stabilizer.h)
+    int stableUpdates = 3;                // hypothesis changes a word must survive to be committed
+    int stableMs = 600;                   // or audio it must stand unchanged for
+
+    // N-best rescoring
+    int alternatives = 0;                 // N-best list size requested from Vosk, 0 = plain results
+    std::string rescorer = "vocabulary";  // none, vocabulary
+    std::string vocabularyFile = "vocabulary.txt";
+    double boostWeight = 5.0;             // score bonus per boosted phrase, in Vosk lattice-score units
+
+    // Punctuation and truecasing of final text
+    bool punctuation = true;
+    std::string textLanguage = "en";      // en, tr (a locale like en-US is fine)
+    double punctuationDeadlineMs = 200.0; // segments waiting longer are only capitalized
+    size_t punctuationBatch = 8;
+
+    // Parallel recognition with a second model (empty = off)
+    std::string parallelModel;
+    std::string parallelLanguage = "tr";
+    double parallelDecideSeconds = 0.0;   // > 0: keep only the better model after this much speech
+
+    // Offline translation of final text
+    bool translation = false;
+    std::string translationSource;        // empty = text-language
+    std::string translationTarget = "en";
+    std::string translationModel = "phrases";   // phrases, stand-in
+    std::string translationTable;         // empty = translation-<source>-<target>.txt
+    size_t translationBatch = 8;
+    size_t translationCache = 1024;       // LRU entries, 0 = no cache
+
+    // Transcript history
+    bool transcriptIndex = true;
+    std::string transcriptDir = "transcripts";
+    size_t indexFlushSegments = 256;      // segments per in-memory delta before it is written as a run
+
+    // Decode scheduler shared by parallel recognition and the server
+    int decodeWorkers = 0;                // 0 = one per core, minus one for capture/I/O
+
+    // Capture thread scheduling
+    std::string capturePolicy = "other";  // other, fifo, rr
+    int capturePriority = 10;             // 1-99 for fifo/rr; rtkit caps it (usually 20)
+    std::string captureCpus;              // "0" or "0,2-3"; empty = any (core 0 when isolating)
+    std::string decodeCpus;               // empty = any (all but the capture cores when isolating)
+    bool captureIsolate = true;           // keep decode off the capture cores on > 2 cores
+    int captureDeadlineMs = 50;           // a read this much later than usual is a deadline miss
+    int captureQueueMs = 2000;            // audio buffered between the capture and recording threads
+    int stopDeadlineMs = 3000;            // stop request to exit; 0 = no limit
+
+    // Transcription server (--serve)
+    std::string serverSocket = "transcribe.sock";
+    int serverChunkMs = 100;              // audio per scheduling turn
+    size_t serverMaxQueue = 50;           // chunks queued per session before its socket is not read
+    int serverReportSeconds = 10;         // 0 = only the per-session summary on close
+    double serverStandInRtf = 0.1;        // CPU cost of the stand-in decoder used without a model
+
+    // Daemon pre-roll
+    size_t preRollSeconds = 3;
+    bool preRollVad = true;
+
+    bool apply(const std::string& key, const std::string& value) {
+        try {
+            if (key == "archive-format") {
+                if (value != "wav" && value != "flac" && value != "opus") return false;
+                archiveFormat = value;
+            } else if (key == "opus-bitrate") {
+                opusBitrateKbps = std::stoi(value);
+            } else if (key == "archive-queue-blocks") {
+                archiveQueueBlocks = std::stoul(value);
+            } else if (key == "segment-seconds") {
+                segmentSeconds = std::stoi(value);
+            } else if (key == "fsync-seconds") {
+                fsyncSeconds = std::stoi(value);
+            } else if (key == "writer-backend") {
+                writerBackend = value;
+            } else if (key == "writer-buffers") {
+                writerBuffers = std::stoul(value);
+            } else if (key == "writer-buffer-kb") {
+                writerBufferKb = std::stoul(value);
+            } else if (key == "writer-threads") {
+                writerThreads = std::stoi(value);
+            } else if (key == "writer-queue-kb") {
+                writerQueueKb = std::stoul(value);
+            } else if (key == "capture-native") {
+                captureNative = parseBool(value);
+            } else if (key == "resampler-taps") {
+                resamplerTaps = std::stoi(value);
+            } else if (key == "prefilter-microphone") {
+                prefilterMicrophone = parseBool(value);
+            } else if (key == "prefilter-monitor") {
+                prefilterMonitor = parseBool(value);
+            } else if (key == "highpass-hz") {
+                highPassHz = std::stof(value);
+            } else if (key == "noise-reduction") {
+                noiseReduction = parseBool(value);
+            } else if (key == "noise-floor-db") {
+                noiseFloorDb = std::stof(value);
+            } else if (key == "agc") {
+                agc = parseBool(value);
+            } else if (key == "microphone-sensitivity") {
+                microphoneSensitivity = std::stoi(value);
+            } else if (key == "agc-target-db") {
+                agcTargetDb = std::stof(value);
+            } else if (key == "agc-attack-ms") {
+                agcAttackMs = std::stof(value);
+            } else if (key == "agc-release-ms") {
+                agcReleaseMs = std::stof(value);
+            } else if (key == "endpoint-profile") {
+                return applyEndpointProfile(value);
+            } else if (key == "endpoint-silence-ms") {
+                endpointSilenceMs = std::stoi(value);
+            } else if (key == "endpoint-max-seconds") {
+                endpointMaxSeconds = std::stof(value);
+            } else if (key == "endpoint-vad-level") {
+                endpointVadLevel = std::stof(value);
+            } else if (key == "stable-updates") {
+                stableUpdates = std::stoi(value);
+            } else if (key == "stable-ms") {
+                stableMs = std::stoi(value);
+            } else if (key == "alternatives") {
+                alternatives = std::stoi(value);
+            } else if (key == "rescorer") {
+                rescorer = value;
+            } else if (key == "vocabulary-file") {
+                vocabularyFile = value;
+            } else if (key == "boost-weight") {
+                boostWeight = std::stod(value);
+            } else if (key == "punctuation") {
+                punctuation = parseBool(value);
+            } else if (key == "text-language") {
+                textLanguage = value;
+            } else if (key == "punctuation-deadline-ms") {
+                punctuationDeadlineMs = std::stod(value);
+            } else if (key == "punctuation-batch") {
+                punctuationBatch = std::stoul(value);
+            } else if (key == "parallel-model") {
+                parallelModel = value;
+            } else if (key == "parallel-language") {
+                parallelLanguage = value;
+            } else if (key == "parallel-decide-seconds") {
+                parallelDecideSeconds = std::stod(value);
+            } else if (key == "translation") {
+                translation = parseBool(value);
+            } else if (key == "translation-source") {
+                translationSource = value == "auto" ? "" : value;
+            } else if (key == "translation-target") {
+                translationTarget = value;
+            } else if (key == "translation-model") {
+                translationModel = value;
+            } else if (key == "translation-table") {
+                translationTable = value;
+            } else if (key == "translation-batch") {
+                translationBatch = std::stoul(value);
+            } else if (key == "translation-cache") {
+                translationCache = std::stoul(value);
+            } else if (key == "transcript-index") {
+                transcriptIndex = parseBool(value);
+            } else if (key == "transcript-dir") {
+                transcriptDir = value;
+            } else if (key == "index-flush-segments") {
+                indexFlushSegments = std::stoul(value);
+            } else if (key == "decode-workers") {
+                decodeWorkers = std::stoi(value);
+            } else if (key == "capture-policy") {
+                if (value != "other" && value != "fifo" && value != "rr") return false;
+                capturePolicy = value;
+            } else if (key == "capture-priority") {
+                capturePriority = std::stoi(value);
+            } else if (key == "capture-cpus") {
+                captureCpus = value;
+            } else if (key == "decode-cpus") {
+                decodeCpus = value;
+            } else if (key == "capture-isolate") {
+                captureIsolate = parseBool(value);
+            } else if (key == "capture-deadline-ms") {
+                captureDeadlineMs = std::stoi(value);
+            } else if (key == "capture-queue-ms") {
+                captureQueueMs = std::stoi(value);
+            } else if (key == "stop-deadline-ms") {
+                stopDeadlineMs = std::stoi(value);
+            } else if (key == "server-socket") {
+                serverSocket = value;
+            } else if (key == "server-chunk-ms") {
+                serverChunkMs = std::stoi(value);
+            } else if (key == "server-max-queue") {
+                serverMaxQueue = std::stoul(value);
+            } else if (key == "server-report-seconds") {
+                serverReportSeconds = std::stoi(value);
+            } else if (key == "server-stand-in-rtf") {
+                serverStandInRtf = std::stod(value);
+            } else if (key == "preroll-seconds") {
+                preRollSeconds = std::stoul(value);
+            } else if (key == "preroll-vad") {
+                preRollVad = parseBool(value);
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+        return true;
+    }
+
+    // Presets; individual endpoint-* keys after the profile override it.
+    bool applyEndpointProfile(const std::string& profile) {
+        if (profile == "model") {
+            endpointSilenceMs = 0;
+            endpointMaxSeconds = 0.0f;
+        } else if (profile == "captions") {
+            endpointSilenceMs = 300;
+            endpointMaxSeconds = 6.0f;
+        } else if (profile == "dictation") {
+            endpointSilenceMs = 1200;
+            endpointMaxSeconds = 30.0f;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    void load(const std::string& filename) {
+        std::ifstream file(filename);
+        if (!file.is_open()) return;
+
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) continue;
+
+            std::string key = trim(line.substr(0, eq));
+            std::string value = trim(line.substr(eq + 1));
+            if (!apply(key, value)) {
+                std::cerr << "⚠️ Ignoring setting: " << key << "=" << value << std::endl;
+            }
+        }
+    }
+
+    static bool parseBool(const std::string& value) {
+        return value == "1" || value == "true" || value == "yes" || value == "on";
+    }
+
+    static std::string trim(const std::string& s) {
+        size_t start = s.find_first_not_of(" \t\r");
+        if (start == std::string::npos) return "";
+        size_t end = s.find_last_not_of(" \t\r");
+        return s.substr(start, end - start + 1);
+    }
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+#include "dsp_kernels.h"
+#include "sample_span.h"
+
+// Rational polyphase resampler (windowed-sinc, Blackman window), e.g.
+// 48000 -> 16000 is 1/3, 44100 -> 16000 is 160/441.
+//
+// The prototype low-pass is split into L phases of `taps` coefficients each,
+// stored reversed and zero-padded to a multiple of 8 so every output sample
+// is a single SIMD dot product over contiguous history.
+class Resampler {
+public:
+    void configure(int inRate, int outRate, int taps) {
+        int g = std::gcd(inRate, outRate);
+        up = outRate / g;
+        down = inRate / g;
+        // `taps` is the filter length at the slower rate; scale it so the
+        // transition band stays the same width when decimating.
+        int factor = (down + up - 1) / up;
+        tapsPerPhase = (std::max(taps, 8) * factor + 7) & ~7;
+
+        // Cutoff relative to the upsampled rate, a little below Nyquist of the
+        // slower side to leave room for the transition band.
+        double cutoff = 0.5 / std::max(up, down) * 0.92;
+        size_t length = static_cast<size_t>(tapsPerPhase) * up;
+        double center = (length - 1) / 2.0;
+
+        std::vector<double> prototype(length);
+        for (size_t k = 0; k < length; k++) {
+            double x = k - center;
+            double sinc = (x == 0.0) ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+            double w = 0.42 - 0.5 * std::cos(2.0 * M_PI * k / (length - 1)) +
+                       0.08 * std::cos(4.0 * M_PI * k / (length - 1));
+            prototype[k] = sinc * w * up;
+        }
+
+        coefficients.assign(length, 0.0f);
+        for (int p = 0; p < up; p++) {
+            for (int j = 0; j < tapsPerPhase; j++) {
+                coefficients[p * tapsPerPhase + (tapsPerPhase - 1 - j)] =
+                    static_cast<float>(prototype[p + j * up]);
+            }
+        }
+
+        history.assign(tapsPerPhase - 1, 0.0f);
+        history.reserve(tapsPerPhase + 8192);   // no reallocation for normal chunk sizes
+        position = 0;
+    }
+
+    // Upper bound on the outputs produced for `count` inputs.
+    size_t maxOutput(size_t count) const {
+        return count * up / down + 2;
+    }
+
+    // Writes up to maxOutput(count) samples to `out`, returns how many.
+    size_t process(const float* in, size_t count, float* out) {
+        history.insert(history.end(), in, in + count);
+
+        size_t produced = 0;
+        size_t available = history.size() - (tapsPerPhase - 1);
+        while (position / up < available) {
+            size_t index = position / up;
+            int phase = static_cast<int>(position % up);
+            out[produced++] = dsp::dot(&coefficients[phase * tapsPerPhase], &history[index], tapsPerPhase);
+            position += down;
+        }
+
+        size_t consumed = std::min<size_t>(position / up, history.size());
+        history.erase(history.begin(), history.begin() + consumed);
+        position -= static_cast<uint64_t>(consumed) * up;
+        return produced;
+    }
+
+    bool identity() const { return up == down; }
+
+private:
+    int up = 1;
+    int down = 1;
+    int tapsPerPhase = 32;
+    std::vector<float> coefficients;
+    std::vector<float> history;
+    uint64_t position = 0;     // next output time in upsampled units
+};
+
+// Turns interleaved native-format capture into mono float at the model rate.
+// Buffers are sized for `maxFrames` per call when configured, so process()
+// does not allocate.
+class CaptureConverter {
+public:
+    void configure(int inRate, int channels, int outRate, int taps, size_t maxFrames) {
+        this->channels = channels;
+        resampler.configure(inRate, outRate, taps);
+        bypass = channels == 1 && resampler.identity();
+        mono.allocate(maxFrames);
+        output.allocate(resampler.maxOutput(maxFrames));
+    }
+
+    bool passthrough() const { return bypass; }
+
+    // Valid until the next call.
+    FloatSpan process(const int16_t* in, size_t frames) {
+        if (resampler.identity()) {
+            dsp::downmixToFloat(in, frames, channels, output.data());
+            return output.span(frames);
+        }
+        dsp::downmixToFloat(in, frames, channels, mono.data());
+        return output.span(resampler.process(mono.data(), frames, output.data()));
+    }
+
+private:
+    int channels = 1;
+    bool bypass = true;
+    Resampler resampler;
+    AlignedBuffer<float> mono;
+    AlignedBuffer<float> output;
+};
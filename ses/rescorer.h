@@ -0,0 +1,199 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "nbest.h"
+#include "recorder_settings.h"
+#include "vocabulary.h"
+
+// Scores one hypothesis; the highest total wins. Implementations are called
+// from the rescoring worker only, so they need no locking of their own.
+class Rescorer {
+public:
+    virtual ~Rescorer() = default;
+    virtual const char* name() const = 0;
+    virtual double score(const Hypothesis& hypothesis) const = 0;
+    // Called before each utterance, e.g. to pick up an edited word list.
+    virtual void refresh() {}
+    // Final chance to rewrite the chosen text.
+    virtual void postProcess(std::string& text) { (void)text; }
+};
+
+// Boosts and rewrites from the user vocabulary file (see vocabulary.h) on
+// top of the recognizer's own score.
+class VocabularyRescorer : public Rescorer {
+public:
+    VocabularyRescorer(const std::string& path, double defaultWeight, VoskModel* model)
+        : path(path), defaultWeight(defaultWeight), model(model) {}
+
+    bool load() {
+        vocabulary.reloadIfChanged(path, defaultWeight, model);
+        return !vocabulary.empty();
+    }
+
+    const char* name() const override { return "vocabulary"; }
+
+    double score(const Hypothesis& hypothesis) const override {
+        return hypothesis.confidence + vocabulary.boost(hypothesis.text);
+    }
+
+    void refresh() override {
+        vocabulary.reloadIfChanged(path, defaultWeight, model);
+    }
+
+    void postProcess(std::string& text) override {
+        vocabulary.rewrite(text, rewritten);
+        text.swap(rewritten);
+    }
+
+private:
+    std::string path;
+    double defaultWeight;
+    VoskModel* model;
+    Vocabulary vocabulary;
+    std::string rewritten;
+};
+
+// Picks the best hypothesis per segment off the capture thread.
+//
+// The capture thread submits finished utterances (one N-best list per
+// recognizer segment) and later collects the chosen text with poll(); it
+// never waits for the rescorer. Results come back in submission order.
+class RescoreWorker {
+public:
+    using Utterance = std::vector<std::vector<Hypothesis>>;
+
+    ~RescoreWorker() {
+        stop();
+    }
+
+    // The vocabulary rescorer also rewrites plain (1-best) results, so it is
+    // used whenever its file has entries. Once running it follows edits to
+    // the file, including one that empties it.
+    static std::unique_ptr<Rescorer> create(const RecorderSettings& settings, VoskModel* model) {
+        if (settings.rescorer == "vocabulary") {
+            auto rescorer = std::make_unique<VocabularyRescorer>(settings.vocabularyFile, settings.boostWeight, model);
+            if (rescorer->load()) {
+                return rescorer;
+            }
+        } else if (settings.rescorer != "none") {
+            std::cerr << "⚠️ Unknown rescorer: " << settings.rescorer << std::endl;
+        }
+        return nullptr;
+    }
+
+    void start(std::unique_ptr<Rescorer> instance) {
+        stop();
+        rescorer = std::move(instance);
+        if (!rescorer) return;
+        jobs = 0;
+        overrides = 0;
+        busyMicros = 0.0;
+        stopping = false;
+        worker = std::thread(&RescoreWorker::run, this);
+    }
+
+    bool active() const { return rescorer != nullptr; }
+
+    void submit(Utterance&& utterance) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(std::move(utterance));
+        }
+        wake.notify_one();
+    }
+
+    // Hands finished texts to `emit(text)`, one per submitted utterance (empty
+    // when no alternative had words); never blocks on the worker.
+    template <typename Emit>
+    void poll(Emit&& emit) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (done.empty()) return;
+            delivered.swap(done);   // both keep their storage, so polling does not allocate
+        }
+        for (const std::string& text : delivered) {
+            emit(text);
+        }
+        delivered.clear();
+    }
+
+    // Waits for everything submitted so far, then stops the thread.
+    void stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    void report() const {
+        if (!rescorer || jobs == 0) return;
+        std::cout << "🏅 Rescoring (" << rescorer->name() << "): " << jobs << " utterances, "
+                  << overrides << " segments changed from the top hypothesis, "
+                  << (busyMicros / jobs) << "µs per utterance" << std::endl;
+    }
+
+private:
+    std::unique_ptr<Rescorer> rescorer;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Utterance> pending;
+    std::deque<std::string> done;
+    std::deque<std::string> delivered;   // poll() only
+    bool stopping = false;
+    uint64_t jobs = 0;
+    uint64_t overrides = 0;
+    double busyMicros = 0.0;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) return;
+            Utterance utterance = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+
+            auto begin = std::chrono::steady_clock::now();
+            rescorer->refresh();
+            std::string text = rescore(utterance);
+            if (!text.empty()) rescorer->postProcess(text);
+            busyMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+            jobs++;
+
+            lock.lock();
+            done.push_back(std::move(text));   // one result per utterance, even if empty
+        }
+    }
+
+    std::string rescore(const Utterance& utterance) {
+        std::string text;
+        for (const auto& alternatives : utterance) {
+            size_t best = 0;
+            double bestScore = 0.0;
+            for (size_t i = 0; i < alternatives.size(); i++) {
+                double s = rescorer->score(alternatives[i]);
+                if (i == 0 || s > bestScore) {
+                    best = i;
+                    bestScore = s;
+                }
+            }
+            if (best != 0) overrides++;
+            if (!alternatives.empty() && !alternatives[best].text.empty()) {
+                text += (text.empty() ? "" : " ") + alternatives[best].text;
+            }
+        }
+        return text;
+    }
+};
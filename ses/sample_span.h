@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Non-owning view of mono samples at the model rate. The capture path hands
+// these around instead of byte buffers so each stage sees the real sample
+// type: int16_t straight from parec, or float (int16 scale, as Vosk's
+// accept_waveform_f expects) once a DSP stage has touched the audio.
+template <typename T>
+struct SampleSpan {
+    T* data = nullptr;
+    size_t size = 0;
+
+    T* begin() const { return data; }
+    T* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+};
+
+using Int16Span = SampleSpan<int16_t>;
+using FloatSpan = SampleSpan<float>;
+
+// Fixed-capacity buffer aligned for SIMD loads. Allocated once up front so the
+// capture loop never touches the heap.
+template <typename T>
+class AlignedBuffer {
+public:
+    static constexpr size_t ALIGNMENT = 32;
+
+    AlignedBuffer() = default;
+    explicit AlignedBuffer(size_t capacity) { allocate(capacity); }
+    ~AlignedBuffer() { std::free(buffer); }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    void allocate(size_t capacity) {
+        std::free(buffer);
+        size_t bytes = (capacity * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        buffer = static_cast<T*>(std::aligned_alloc(ALIGNMENT, bytes ? bytes : ALIGNMENT));
+        if (!buffer) throw std::bad_alloc();
+        count = capacity;
+    }
+
+    T* data() { return buffer; }
+    const T* data() const { return buffer; }
+    size_t capacity() const { return count; }
+
+    SampleSpan<T> span(size_t size) { return {buffer, size}; }
+
+private:
+    T* buffer = nullptr;
+    size_t count = 0;
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Bounds how long stopping a recording may take, and shows where the time
+// went. start() when the stop is requested; each shutdown step names itself
+// with phase(), and textWritten() marks the moment the last words are in
+// the transcript, which is the stop latency the user sees.
+//
+// With a hard deadline a watchdog thread ends the process if finish() has
+// not been reached in time, naming the step it was stuck in. Shutdown
+// writes the transcript before the slower sinks (translation, the index,
+// the archive), so those are what a deadline cuts short. Even then the
+// text update stream already holds the last partial, which the extension
+// takes as final once the process has gone.
+class StopDeadline {
+public:
+    ~StopDeadline() {
+        finish();
+    }
+
+    // Starts the clock; calls after the first are ignored. `deadlineMs` 0
+    // means no limit.
+    void start(int deadlineMs, bool hard) {
+        if (started) return;
+        started = true;
+        begin = stepBegin = Clock::now();
+        limitMs = deadlineMs;
+        current = "loop";
+        steps.clear();
+        textMs = -1.0;
+        drainedBlocks = droppedBlocks = 0;
+        done = false;
+        if (hard && deadlineMs > 0) watchdog = std::thread(&StopDeadline::watch, this);
+    }
+
+    bool active() const { return started; }
+
+    double elapsedMs() const {
+        return started ? std::chrono::duration<double, std::milli>(Clock::now() - begin).count() : 0.0;
+    }
+
+    // Whether a step that can stop early (draining the capture queue) may
+    // still spend time: until half the deadline is used.
+    bool withinBudget() const {
+        return limitMs <= 0 || elapsedMs() < limitMs / 2.0;
+    }
+
+    // Ends the running step and starts `name`.
+    void phase(const char* name) {
+        if (!started) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        closeStep();
+        current = name;
+    }
+
+    void textWritten() {
+        if (started && textMs < 0.0) textMs = elapsedMs();
+    }
+
+    void drained(size_t blocks, size_t dropped) {
+        drainedBlocks += blocks;
+        droppedBlocks += dropped;
+    }
+
+    // Shutdown is complete; stops the watchdog.
+    void finish() {
+        if (!started) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!done) {
+                closeStep();
+                totalMs = elapsedMs();
+            }
+            done = true;
+        }
+        wake.notify_one();
+        if (watchdog.joinable()) watchdog.join();
+    }
+
+    void report() const {
+        if (!started || !done) return;
+        std::cout << "⏹️ Stop: ";
+        if (textMs >= 0.0) std::cout << "last words written " << static_cast<long>(textMs) << " ms after the request, ";
+        std::cout << "done in " << static_cast<long>(totalMs) << " ms (";
+        for (size_t i = 0; i < steps.size(); i++) {
+            std::cout << (i > 0 ? ", " : "") << steps[i].first << " " << steps[i].second;
+        }
+        std::cout << "), " << drainedBlocks << " queued blocks decoded";
+        if (droppedBlocks > 0) std::cout << ", " << droppedBlocks << " dropped to meet the deadline";
+        if (limitMs > 0) std::cout << "; deadline " << limitMs << " ms";
+        std::cout << std::endl;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool started = false;
+    bool done = false;                    // guarded by the mutex once the watchdog runs
+    int limitMs = 0;
+    Clock::time_point begin;
+    Clock::time_point stepBegin;
+    const char* current = "loop";         // running step; the first is the loop finishing its batch
+    std::vector<std::pair<const char*, long>> steps;   // name, ms
+    double textMs = -1.0;
+    double totalMs = 0.0;
+    size_t drainedBlocks = 0;
+    size_t droppedBlocks = 0;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread watchdog;
+
+    void closeStep() {
+        Clock::time_point now = Clock::now();
+        steps.emplace_back(current, static_cast<long>(std::chrono::duration<double, std::milli>(now - stepBegin).count()));
+        stepBegin = now;
+    }
+
+    void watch() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (wake.wait_until(lock, begin + std::chrono::milliseconds(limitMs), [this] { return done; })) return;
+        std::cerr << "\n⏱️ Stop deadline of " << limitMs << " ms passed while in \"" << current
+                  << "\"; exiting without it" << std::endl;
+        fflush(stdout);
+        _exit(3);
+    }
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool for decode steps.
+//
+// Every worker has its own task queue. A task submitted from a worker goes
+// to that worker's queue, so a recognizer that re-submits its next step
+// stays on the core whose caches hold its state. Tasks from other threads
+// are spread round-robin. A worker takes from the front of its own queue
+// (FIFO, so streams sharing a worker take turns) and, when it runs dry,
+// steals from the back of the others'. Idle workers sleep on one condition
+// variable; there is no spinning.
+//
+// A recognizer must only ever run on one thread at a time; use a Strand
+// (below) or the same one-in-flight rule for its steps.
+class TaskScheduler {
+public:
+    using Task = std::function<void()>;
+
+    ~TaskScheduler() {
+        stop();
+    }
+
+    // A non-empty `cpus` pins worker i to cpus[i % cpus.size()].
+    void start(int workers, const std::vector<int>& cpus = {}) {
+        stop();
+        if (workers <= 0) workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+        queues.clear();
+        for (int i = 0; i < workers; i++) queues.push_back(std::make_unique<Queue>());
+        pending = 0;
+        executed = 0;
+        steals = 0;
+        nextQueue = 0;
+        stopping = false;
+        for (int i = 0; i < workers; i++) {
+            threads.emplace_back(&TaskScheduler::run, this, i);
+            if (!cpus.empty()) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpus[i % cpus.size()], &set);
+                pthread_setaffinity_np(threads.back().native_handle(), sizeof(set), &set);
+            }
+        }
+    }
+
+    // Runs every task already queued, then joins the workers.
+    void stop() {
+        if (threads.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+            stopping = true;
+        }
+        idle.notify_all();
+        for (auto& thread : threads) thread.join();
+        threads.clear();
+    }
+
+    bool running() const { return !threads.empty(); }
+    int workerCount() const { return static_cast<int>(threads.size()); }
+
+    void submit(Task task) {
+        size_t index = current == this ? currentIndex : nextQueue++ % queues.size();
+        {
+            // Counted under the same lock as the push, so a worker that
+            // takes the task cannot decrement before it is counted.
+            std::lock_guard<std::mutex> idleLock(idleMutex);
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(task));
+            pending++;
+        }
+        idle.notify_one();
+    }
+
+    void report() const {
+        if (executed == 0) return;
+        std::cout << "🧵 Scheduler: " << threads.size() << " workers, " << executed << " tasks, "
+                  << steals << " stolen (" << (100.0 * steals / executed) << "%)" << std::endl;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex idleMutex;
+    std::condition_variable idle;
+    size_t pending = 0;                     // queued, not yet taken; guarded by idleMutex
+    bool stopping = false;
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> steals{0};
+
+    static thread_local TaskScheduler* current;
+    static thread_local size_t currentIndex;
+
+    bool take(size_t index, Task& task) {
+        {
+            Queue& own = *queues[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.front());
+                own.tasks.pop_front();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); i++) {
+            Queue& victim = *queues[(index + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.back());
+                victim.tasks.pop_back();
+                steals++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(size_t index) {
+        current = this;
+        currentIndex = index;
+        Task task;
+        while (true) {
+            if (take(index, task)) {
+                {
+                    std::lock_guard<std::mutex> lock(idleMutex);
+                    pending--;
+                }
+                task();
+                task = nullptr;
+                executed++;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idleMutex);
+            idle.wait(lock, [this] { return stopping || pending > 0; });
+            if (pending == 0) return;   // stopping and drained
+        }
+    }
+};
+
+inline thread_local TaskScheduler* TaskScheduler::current = nullptr;
+inline thread_local size_t TaskScheduler::currentIndex = 0;
+
+// Runs the tasks posted to it one at a time, in order, on any scheduler
+// worker; one recognizer's decode steps go through one strand. After each
+// task the strand re-queues itself behind whatever else is waiting, so a
+// stream with a long backlog cannot hold a worker while others wait.
+class Strand {
+public:
+    explicit Strand(TaskScheduler& scheduler) : scheduler(scheduler) {}
+
+    ~Strand() {
+        drain();
+    }
+
+    void post(TaskScheduler::Task task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        if (!scheduled) {
+            scheduled = true;
+            scheduler.submit([this] { runOne(); });
+        }
+    }
+
+    // Waits until everything posted so far has run.
+    void drain() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return !scheduled; });
+    }
+
+    // Drops tasks that have not started.
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.clear();
+    }
+
+    size_t depth() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tasks.size();
+    }
+
+private:
+    TaskScheduler& scheduler;
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::deque<TaskScheduler::Task> tasks;
+    bool scheduled = false;
+
+    void runOne() {
+        TaskScheduler::Task task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!tasks.empty()) {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+        }
+        if (task) task();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) {
+            scheduled = false;
+            idle.notify_all();
+        } else {
+            scheduler.submit([this] { runOne(); });
+        }
+    }
+};
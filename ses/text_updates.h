@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include "async_writer.h"
+
+// Append-only stream of edits to the displayed text, so a reader applies a
+// short diff per update instead of re-reading and re-rendering the whole
+// transcript. One line per update:
+//
+//   <segment> <p|f> <keep> <stable> <tail>
+//
+// Segment `segment` becomes its first `keep` characters followed by
+// `tail` (the rest of the line, possibly empty). Its first `stable`
+// characters are committed (see partial_stabilizer.h) and will not change
+// before the final; the rest is tentative. `p` is a partial hypothesis;
+// `f` is the segment's final text, all of it stable, after which it does
+// not change again. Segments are utterances, numbered from 0 per session; a
+// final can arrive after the next segment's partials (rescoring and
+// punctuation finish in the background), which is why every line carries
+// its segment. `keep` counts UTF-16 code units, so a JavaScript reader can
+// apply it with slice(0, keep) directly.
+class TextUpdateStream {
+public:
+    // Starts over in `file` of `writer`, truncating it; the reader starts
+    // over when it sees it shrink.
+    void open(AsyncWriter& writer, int file) {
+        output = &writer;
+        handle = file;
+        output->replace(handle, std::string_view());
+        segments.clear();
+        lines = partials = finals = bytes = fullBytes = 0;
+    }
+
+    // New hypothesis for `segment`, of which the first `stableBytes` are
+    // committed; nothing is written when neither changed.
+    void partial(uint64_t segment, std::string_view text, size_t stableBytes) {
+        if (segments.empty() || segments.back().id != segment) segments.push_back({segment, {}, 0});
+        Segment& shown = segments.back();
+        if (text == shown.text && stableBytes == shown.stable) return;
+        write(segment, 'p', shown.text, text, stableBytes);
+        shown.text.assign(text.data(), text.size());
+        shown.stable = stableBytes;
+        partials++;
+    }
+
+    // Final text of `segment`, diffed against its last partial. A segment
+    // that never showed anything and has no text is not written at all.
+    void finalize(uint64_t segment, std::string_view text) {
+        auto it = segments.begin();
+        while (it != segments.end() && it->id != segment) ++it;
+        if (it == segments.end()) {
+            if (!text.empty()) write(segment, 'f', {}, text, text.size());
+        } else {
+            write(segment, 'f', it->text, text, text.size());
+            segments.erase(it);
+        }
+        finals++;
+    }
+
+    // Bytes written against what rewriting the whole segment each time
+    // would have cost.
+    void report() const {
+        if (lines == 0) return;
+        std::cout << "📝 Text updates: " << lines << " (" << partials << " partial, " << finals << " final), "
+                  << bytes / 1024.0 << " KB written, " << fullBytes / 1024.0 << " KB as whole rewrites ("
+                  << (bytes > 0 ? static_cast<double>(fullBytes) / bytes : 0.0) << "x)" << std::endl;
+    }
+
+private:
+    struct Segment {
+        uint64_t id;
+        std::string text;                 // last partial shown
+        size_t stable;                    // committed bytes of it
+    };
+
+    AsyncWriter* output = nullptr;
+    int handle = -1;
+    std::deque<Segment> segments;         // shown, final not yet written; oldest first
+    uint64_t lines = 0;
+    uint64_t partials = 0;
+    uint64_t finals = 0;
+    uint64_t bytes = 0;
+    uint64_t fullBytes = 0;
+
+    void write(uint64_t segment, char kind, std::string_view previous, std::string_view text, size_t stableBytes) {
+        size_t common = 0;
+        while (common < previous.size() && common < text.size() && previous[common] == text[common]) common++;
+        // Back up to the start of a character
+        while (common > 0 && common < text.size() && (static_cast<unsigned char>(text[common]) & 0xC0) == 0x80) {
+            common--;
+        }
+        std::string_view tail = text.substr(common);
+
+        char head[64];
+        int headLength = snprintf(head, sizeof(head), "%llu %c %zu %zu ", static_cast<unsigned long long>(segment),
+                                  kind, utf16Length(text.substr(0, common)), utf16Length(text.substr(0, stableBytes)));
+        // Readers only take complete lines, so one caught half-written is
+        // picked up on their next poll
+        if (output) output->append(handle, {std::string_view(head, headLength), tail, "\n"});
+        lines++;
+        bytes += headLength + tail.size() + 1;
+        fullBytes += text.size() + 1;
+    }
+
+    static size_t utf16Length(std::string_view utf8) {
+        size_t units = 0;
+        for (unsigned char byte : utf8) {
+            if ((byte & 0xC0) != 0x80) units++;   // one per character...
+            if (byte >= 0xF0) units++;            // ...two outside the BMP
+        }
+        return units;
+    }
+};
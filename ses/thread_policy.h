@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Scheduling class and CPU placement for the threads that matter to latency.
+namespace threadPolicy {
+
+// "0,2-3" -> {0, 2, 3}. Cores beyond the machine are dropped.
+inline std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int first = 0, last = 0;
+        int fields = sscanf(item.c_str(), "%d-%d", &first, &last);
+        if (fields < 1) continue;
+        if (fields == 1) last = first;
+        for (int cpu = first; cpu <= last; cpu++) {
+            if (cpu >= 0 && (cores <= 0 || cpu < cores)) cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// Every core not in `excluded`.
+inline std::vector<int> otherCpus(const std::vector<int>& excluded) {
+    std::vector<int> cpus;
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < cores; cpu++) {
+        bool taken = false;
+        for (int other : excluded) taken |= other == cpu;
+        if (!taken) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Restricts the calling thread to `cpus` (all of them, not one each).
+inline bool setAffinity(const std::vector<int>& cpus) {
+    if (cpus.empty()) return true;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+inline std::string describe(const std::vector<int>& cpus) {
+    std::string out;
+    for (int cpu : cpus) out += (out.empty() ? "" : ",") + std::to_string(cpu);
+    return out.empty() ? "any" : out;
+}
+
+inline bool trySchedule(int policy, int priority) {
+    sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    // Children (parec restarts, busctl) must not inherit real-time priority
+    return sched_setscheduler(0, policy | SCHED_RESET_ON_FORK, &param) == 0;
+}
+
+// Asks RealtimeKit, the way PulseAudio and PipeWire get real-time priority
+// for desktop users. rtkit only grants SCHED_RR, caps the priority, and
+// insists on a finite RLIMIT_RTTIME so a runaway thread is demoted by the
+// kernel instead of freezing the desktop.
+inline bool tryRtkit(int& priority) {
+    rlimit rttime = {200000, 200000};   // µs of CPU without blocking
+    setrlimit(RLIMIT_RTTIME, &rttime);
+    const char* service = "org.freedesktop.RealtimeKit1 /org/freedesktop/RealtimeKit1 org.freedesktop.RealtimeKit1";
+    FILE* pipe = popen(("busctl --system get-property " + std::string(service) +
+                        " MaxRealtimePriority 2>/dev/null").c_str(), "r");
+    if (!pipe) return false;
+    int maxPriority = 0;
+    if (fscanf(pipe, "i %d", &maxPriority) != 1) maxPriority = 0;
+    pclose(pipe);
+    if (maxPriority <= 0) return false;
+    priority = std::min(priority, maxPriority);
+    std::string call = "busctl --system call " + std::string(service) + " MakeThreadRealtime tu " +
+                       std::to_string(syscall(SYS_gettid)) + " " + std::to_string(priority) + " >/dev/null 2>&1";
+    return system(call.c_str()) == 0;
+}
+
+// Puts the calling thread in SCHED_FIFO or SCHED_RR ("fifo"/"rr"; "other"
+// leaves it alone). Tries, in order: directly (root, CAP_SYS_NICE or a
+// sufficient RLIMIT_RTPRIO), after raising the RLIMIT_RTPRIO soft limit to
+// the hard one (limits.conf @audio rtprio), then rtkit. Returns how it got
+// there, or an empty string when the thread stays at normal priority.
+inline std::string applyRealtime(const std::string& name, int priority, const char* label) {
+    if (name == "other" || name.empty()) return "";
+    int policy = name == "rr" ? SCHED_RR : SCHED_FIFO;
+    priority = std::max(sched_get_priority_min(policy), std::min(priority, sched_get_priority_max(policy)));
+    if (trySchedule(policy, priority)) return name + " " + std::to_string(priority);
+
+    rlimit limit;
+    if (getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_max != 0) {
+        if (limit.rlim_max != RLIM_INFINITY && static_cast<int>(limit.rlim_max) < priority) {
+            priority = static_cast<int>(limit.rlim_max);
+        }
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_RTPRIO, &limit) == 0 && trySchedule(policy, priority)) {
+            return name + " " + std::to_string(priority) + " (rlimit)";
+        }
+    }
+
+    if (tryRtkit(priority)) return "rr " + std::to_string(priority) + " (rtkit)";
+
+    std::cerr << "⚠️ " << label << ": real-time priority not permitted (no rtprio limit, no rtkit), "
+              << "staying at normal priority" << std::endl;
+    return "";
+}
+
+}  // namespace threadPolicy
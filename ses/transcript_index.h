@@ -0,0 +1,873 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "endpointer.h"
+
+// Persistent full-text index over every finalized segment of every session.
+//
+// Layout of the index directory:
+//   sessions.tsv   id, archive path, sample rate, start time; one line per session
+//   segments.log   append-only segment records (session, sample range, language, text)
+//   segments.idx   u64 offset into segments.log per segment id
+//   run-A-B.idx    immutable inverted index over segments [A, B)
+//
+// A run is a postings blob followed by a term dictionary sorted by term and
+// an array of dictionary offsets, so a lookup is a binary search over an
+// mmap'd file. Postings are varint-coded: per segment the delta to the
+// previous segment id, the number of positions, then position deltas.
+//
+// Segments are indexed incrementally: add() appends the record (fdatasync'd)
+// and the postings to an in-memory delta, which flush() writes as a new run.
+// Runs of similar size are merged (each segment is rewritten O(log n)
+// times), so a few thousand hours stay at a handful of runs. After a crash
+// the segments past the last run are re-indexed from segments.log on open,
+// and a reader does the same, so searches see everything logged so far.
+class TranscriptIndex {
+public:
+    struct Hit {
+        uint64_t segment = 0;
+        std::string archive;
+        int sampleRate = 16000;
+        StreamRange range;
+        std::string language;
+        std::string text;
+    };
+
+    ~TranscriptIndex() {
+        close();
+    }
+
+    bool open(const std::string& path, bool writable) {
+        close();
+        directory = path;
+        this->writable = writable;
+        if (writable && mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+            std::cerr << "❌ Could not create transcript index: " << directory << std::endl;
+            return false;
+        }
+        int flags = writable ? (O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC) : (O_RDONLY | O_CLOEXEC);
+        logFd = ::open((directory + "/segments.log").c_str(), flags, 0644);
+        idxFd = ::open((directory + "/segments.idx").c_str(), flags, 0644);
+        if (logFd < 0 || idxFd < 0) {
+            close();
+            return false;
+        }
+        if (writable) repairSegmentIndex();
+        loadSessions();
+        loadRuns();
+
+        // Segments logged after the last run (crash, or a recording still
+        // running in another process) go to the in-memory delta
+        uint64_t count = segmentCount();
+        deltaFirst = coveredEnd;
+        nextSegment = coveredEnd;
+        Hit record;
+        for (uint64_t id = coveredEnd; id < count; id++) {
+            if (readSegment(id, record)) indexText(id, record.text);
+            nextSegment = id + 1;
+        }
+        return true;
+    }
+
+    void close() {
+        for (Run& run : runs) unmap(run);
+        runs.clear();
+        delta.clear();
+        sessions.clear();
+        if (logFd >= 0) ::close(logFd);
+        if (idxFd >= 0) ::close(idxFd);
+        logFd = idxFd = -1;
+        coveredEnd = deltaFirst = nextSegment = 0;
+    }
+
+    uint64_t segmentCount() const {
+        struct stat info;
+        if (idxFd < 0 || fstat(idxFd, &info) != 0) return 0;
+        return static_cast<uint64_t>(info.st_size) / sizeof(uint64_t);
+    }
+
+    size_t runCount() const { return runs.size(); }
+
+    // Skips the per-segment fdatasync (bulk loads and benchmarks).
+    void setDurable(bool durable) { this->durable = durable; }
+
+    uint32_t beginSession(const std::string& archive, int sampleRate) {
+        uint32_t id = static_cast<uint32_t>(sessions.size());
+        sessions.push_back({archive, sampleRate});
+        std::ofstream file(directory + "/sessions.tsv", std::ios::app);
+        file << id << '\t' << archive << '\t' << sampleRate << '\t' << time(nullptr) << '\n';
+        return id;
+    }
+
+    // Appends one segment and indexes it; returns its id.
+    uint64_t add(uint32_t session, const StreamRange& range, const std::string& language,
+                 const std::string& text) {
+        record.clear();
+        putFixed(record, session, 4);
+        putFixed(record, range.begin, 8);
+        putFixed(record, range.end, 8);
+        size_t languageBytes = std::min<size_t>(language.size(), 255);
+        putFixed(record, languageBytes, 1);
+        record.append(language, 0, languageBytes);
+        putFixed(record, text.size(), 4);
+        record += text;
+
+        struct stat info;
+        fstat(logFd, &info);
+        uint64_t offset = static_cast<uint64_t>(info.st_size);
+        writeAll(logFd, record.data(), record.size());
+        if (durable) fdatasync(logFd);
+        writeAll(idxFd, &offset, sizeof(offset));
+        if (durable) fdatasync(idxFd);
+
+        uint64_t id = nextSegment++;
+        indexText(id, text);
+        return id;
+    }
+
+    // Writes the delta as a run, then merges runs of similar size.
+    void flush() {
+        if (!writable || nextSegment == deltaFirst) return;
+        std::string blob;
+        std::vector<DictEntry> dictionary;
+        std::vector<std::string> terms;
+        terms.reserve(delta.size());
+        for (const auto& entry : delta) terms.push_back(entry.first);
+        std::sort(terms.begin(), terms.end());
+        for (const std::string& term : terms) {
+            const TermPostings& postings = delta[term];
+            dictionary.push_back({term, postings.segments, postings.lastSegment, blob.size(),
+                                  postings.bytes.size()});
+            blob += postings.bytes;
+        }
+        if (!writeRun(deltaFirst, nextSegment, blob, dictionary)) return;
+        delta.clear();
+        deltaFirst = nextSegment;
+
+        while (runs.size() >= 2) {
+            const Run& older = runs[runs.size() - 2];
+            const Run& newer = runs.back();
+            if (older.end - older.first > 2 * (newer.end - newer.first)) break;
+            if (!mergeLastTwo()) break;
+        }
+    }
+
+    // All words of the query, in any order; a query in double quotes must
+    // match as a phrase. Newest segments first.
+    std::vector<Hit> search(const std::string& query, size_t limit) const {
+        std::vector<Hit> hits;
+        std::vector<std::string> terms;
+        std::vector<uint32_t> positionsUnused;
+        tokenize(query, terms, positionsUnused);
+        if (terms.empty()) return hits;
+        bool phrase = query.find('"') != std::string::npos;
+
+        std::vector<std::string> unique = terms;
+        std::sort(unique.begin(), unique.end());
+        unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+        std::unordered_map<std::string, PostingList> lists;
+        for (const std::string& term : unique) {
+            PostingList& list = lists[term];
+            collect(term, list, phrase);
+            if (list.segments.empty()) return hits;
+        }
+        std::sort(unique.begin(), unique.end(), [&](const std::string& a, const std::string& b) {
+            return lists[a].segments.size() < lists[b].segments.size();
+        });
+
+        // Intersect, rarest term first
+        std::vector<uint64_t> candidates;
+        for (const Posting& p : lists[unique[0]].segments) candidates.push_back(p.segment);
+        for (size_t t = 1; t < unique.size() && !candidates.empty(); t++) {
+            const std::vector<Posting>& other = lists[unique[t]].segments;
+            size_t keep = 0, j = 0;
+            for (uint64_t segment : candidates) {
+                while (j < other.size() && other[j].segment < segment) j++;
+                if (j < other.size() && other[j].segment == segment) candidates[keep++] = segment;
+            }
+            candidates.resize(keep);
+        }
+
+        for (auto it = candidates.rbegin(); it != candidates.rend() && hits.size() < limit; ++it) {
+            if (phrase && !matchesPhrase(*it, terms, lists)) continue;
+            Hit hit;
+            if (readSegment(*it, hit)) hits.push_back(std::move(hit));
+        }
+        return hits;
+    }
+
+    // Lowercased words with their positions. Apostrophes split words
+    // ("istanbul'a" -> istanbul, a) and Turkish capitals and dotless i are
+    // folded, so a sentence-initial "İstanbul" matches "istanbul".
+    static void tokenize(const std::string& text, std::vector<std::string>& terms,
+                         std::vector<uint32_t>& positions) {
+        terms.clear();
+        positions.clear();
+        std::string term;
+        auto finish = [&] {
+            if (term.empty()) return;
+            if (term.size() > MAX_TERM_BYTES) term.resize(MAX_TERM_BYTES);
+            positions.push_back(static_cast<uint32_t>(terms.size()));
+            terms.push_back(term);
+            term.clear();
+        };
+        static const char* const folds[][2] = {
+            {"\xC4\xB0", "i"},             // İ
+            {"\xC4\xB1", "i"},             // ı
+            {"\xC3\x87", "\xC3\xA7"},      // Ç
+            {"\xC4\x9E", "\xC4\x9F"},      // Ğ
+            {"\xC3\x96", "\xC3\xB6"},      // Ö
+            {"\xC5\x9E", "\xC5\x9F"},      // Ş
+            {"\xC3\x9C", "\xC3\xBC"},      // Ü
+        };
+        for (size_t i = 0; i < text.size();) {
+            unsigned char c = text[i];
+            if (c < 0x80) {
+                if (std::isalnum(c)) {
+                    term += static_cast<char>(std::tolower(c));
+                } else {
+                    finish();
+                }
+                i++;
+                continue;
+            }
+            size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2;
+            length = std::min(length, text.size() - i);
+            bool folded = false;
+            if (length == 2) {
+                for (const auto& fold : folds) {
+                    if (text.compare(i, 2, fold[0]) == 0) {
+                        term += fold[1];
+                        folded = true;
+                        break;
+                    }
+                }
+            }
+            if (!folded) term.append(text, i, length);
+            i += length;
+        }
+        finish();
+    }
+
+    bool readSegment(uint64_t id, Hit& hit) const {
+        uint64_t offset;
+        if (pread(idxFd, &offset, sizeof(offset), static_cast<off_t>(id * sizeof(offset))) != sizeof(offset)) {
+            return false;
+        }
+        unsigned char header[21];
+        if (pread(logFd, header, sizeof(header), static_cast<off_t>(offset)) != sizeof(header)) return false;
+        const unsigned char* p = header;
+        uint32_t session = static_cast<uint32_t>(getFixed(p, 4));
+        hit.range.begin = getFixed(p, 8);
+        hit.range.end = getFixed(p, 8);
+        size_t languageBytes = static_cast<size_t>(getFixed(p, 1));
+        std::string rest(languageBytes + 4, '\0');
+        off_t at = static_cast<off_t>(offset + sizeof(header));
+        if (pread(logFd, &rest[0], rest.size(), at) != static_cast<ssize_t>(rest.size())) return false;
+        hit.language = rest.substr(0, languageBytes);
+        p = reinterpret_cast<const unsigned char*>(rest.data() + languageBytes);
+        size_t textBytes = static_cast<size_t>(getFixed(p, 4));
+        hit.text.assign(textBytes, '\0');
+        at += static_cast<off_t>(rest.size());
+        if (textBytes && pread(logFd, &hit.text[0], textBytes, at) != static_cast<ssize_t>(textBytes)) return false;
+        hit.segment = id;
+        if (session < sessions.size()) {
+            hit.archive = sessions[session].archive;
+            hit.sampleRate = sessions[session].sampleRate;
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t MAX_TERM_BYTES = 64;
+    static constexpr size_t HEADER_BYTES = 40;
+
+    struct Session {
+        std::string archive;
+        int sampleRate;
+    };
+
+    struct TermPostings {
+        std::string bytes;
+        uint64_t lastSegment = 0;
+        uint32_t segments = 0;
+    };
+
+    struct DictEntry {
+        std::string term;
+        uint32_t segments;
+        uint64_t lastSegment;
+        uint64_t offset;
+        uint64_t bytes;
+    };
+
+    struct Run {
+        std::string path;
+        uint64_t first = 0;
+        uint64_t end = 0;
+        const unsigned char* base = nullptr;
+        size_t size = 0;
+        uint32_t terms = 0;
+        uint64_t dictOffset = 0;
+        uint64_t offsetsOffset = 0;
+    };
+
+    struct Posting {
+        uint64_t segment;
+        uint32_t firstPosition;   // index into PostingList::positions
+        uint32_t positionCount;
+    };
+
+    struct PostingList {
+        std::vector<Posting> segments;
+        std::vector<uint32_t> positions;
+    };
+
+    std::string directory;
+    bool writable = false;
+    bool durable = true;
+    int logFd = -1;
+    int idxFd = -1;
+    std::vector<Session> sessions;
+    std::vector<Run> runs;                         // by first segment, disjoint
+    std::unordered_map<std::string, TermPostings> delta;
+    uint64_t coveredEnd = 0;                       // segments below this are in runs
+    uint64_t deltaFirst = 0;
+    uint64_t nextSegment = 0;
+    std::string record;                            // scratch
+    std::vector<std::string> scratchTerms;
+    std::vector<uint32_t> scratchPositions;
+
+    static void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    static uint64_t getVarint(const unsigned char*& p) {
+        uint64_t value = 0;
+        int shift = 0;
+        while (*p & 0x80) {
+            value |= static_cast<uint64_t>(*p++ & 0x7F) << shift;
+            shift += 7;
+        }
+        value |= static_cast<uint64_t>(*p++) << shift;
+        return value;
+    }
+
+    static void putFixed(std::string& out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) out += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+
+    static uint64_t getFixed(const unsigned char*& p, int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) value |= static_cast<uint64_t>(*p++) << (8 * i);
+        return value;
+    }
+
+    static void writeAll(int fd, const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t written = write(fd, p, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "⚠️ Transcript index write failed: " << strerror(errno) << std::endl;
+                return;
+            }
+            p += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    void indexText(uint64_t id, const std::string& text) {
+        tokenize(text, scratchTerms, scratchPositions);
+        // Group positions per term; segments are short, so a linear scan is fine
+        for (size_t i = 0; i < scratchTerms.size(); i++) {
+            const std::string& term = scratchTerms[i];
+            bool seen = false;
+            for (size_t j = 0; j < i; j++) {
+                if (scratchTerms[j] == term) {
+                    seen = true;
+                    break;
+                }
+            }
+            if (seen) continue;
+            TermPostings& postings = delta[term];
+            size_t count = 0;
+            for (size_t j = i; j < scratchTerms.size(); j++) {
+                if (scratchTerms[j] == term) count++;
+            }
+            putVarint(postings.bytes, id - postings.lastSegment);
+            putVarint(postings.bytes, count);
+            uint32_t previous = 0;
+            for (size_t j = i; j < scratchTerms.size(); j++) {
+                if (scratchTerms[j] != term) continue;
+                putVarint(postings.bytes, scratchPositions[j] - previous);
+                previous = scratchPositions[j];
+            }
+            postings.lastSegment = id;
+            postings.segments++;
+        }
+    }
+
+    void loadSessions() {
+        sessions.clear();
+        std::ifstream file(directory + "/sessions.tsv");
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t a = line.find('\t');
+            size_t b = a == std::string::npos ? a : line.find('\t', a + 1);
+            if (b == std::string::npos) continue;
+            sessions.push_back({line.substr(a + 1, b - a - 1), std::atoi(line.c_str() + b + 1)});
+        }
+    }
+
+    // A torn append leaves segments.idx at a size that is not a multiple of
+    // 8, which would shift every later id, and a log write that did not
+    // reach the disk leaves entries pointing past the end of segments.log.
+    // Both are cut off before the next append.
+    void repairSegmentIndex() {
+        struct stat logInfo, idxInfo;
+        if (fstat(logFd, &logInfo) != 0 || fstat(idxFd, &idxInfo) != 0) return;
+        uint64_t logSize = static_cast<uint64_t>(logInfo.st_size);
+        uint64_t count = static_cast<uint64_t>(idxInfo.st_size) / sizeof(uint64_t);
+        uint64_t offset;
+        while (count > 0 &&
+               pread(idxFd, &offset, sizeof(offset), static_cast<off_t>((count - 1) * sizeof(offset))) == sizeof(offset) &&
+               offset >= logSize) {
+            count--;
+        }
+        off_t size = static_cast<off_t>(count * sizeof(uint64_t));
+        if (size == idxInfo.st_size) return;
+        std::cerr << "⚠️ Transcript index: dropping " << (idxInfo.st_size - size)
+                  << " bytes of unfinished segment entries" << std::endl;
+        if (ftruncate(idxFd, size) != 0) {
+            std::cerr << "⚠️ Transcript index repair failed: " << strerror(errno) << std::endl;
+        }
+    }
+
+    // Maps every run file. A run whose range lies inside another's is left
+    // over from an interrupted merge and is skipped (and removed by a writer),
+    // as are the temporary files of a run write that did not finish.
+    void loadRuns() {
+        std::vector<Run> found;
+        DIR* dir = opendir(directory.c_str());
+        if (dir) {
+            while (dirent* entry = readdir(dir)) {
+                unsigned long long first, end;
+                int consumed = -1;
+                size_t length = strlen(entry->d_name);
+                if (writable && length > 4 && strncmp(entry->d_name, "run-", 4) == 0 &&
+                    strcmp(entry->d_name + length - 4, ".tmp") == 0) {
+                    unlink((directory + "/" + entry->d_name).c_str());
+                    continue;
+                }
+                if (sscanf(entry->d_name, "run-%llu-%llu.idx%n", &first, &end, &consumed) == 2 &&
+                    consumed == static_cast<int>(length)) {
+                    Run run;
+                    run.path = directory + "/" + entry->d_name;
+                    run.first = first;
+                    run.end = end;
+                    found.push_back(run);
+                }
+            }
+            closedir(dir);
+        }
+        std::sort(found.begin(), found.end(), [](const Run& a, const Run& b) {
+            return a.first != b.first ? a.first < b.first : a.end > b.end;
+        });
+        coveredEnd = 0;
+        for (Run& run : found) {
+            if (run.first != coveredEnd) {
+                if (writable && run.end <= coveredEnd) unlink(run.path.c_str());
+                continue;
+            }
+            if (!map(run)) {
+                // Its segments and any later ones are re-indexed from the log
+                std::cerr << "⚠️ Transcript index run is damaged, skipped: " << run.path << std::endl;
+                break;
+            }
+            coveredEnd = run.end;
+            runs.push_back(run);
+        }
+    }
+
+    static bool map(Run& run) {
+        int fd = ::open(run.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat info;
+        bool ok = fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= HEADER_BYTES;
+        if (ok) {
+            run.size = static_cast<size_t>(info.st_size);
+            void* data = mmap(nullptr, run.size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = data != MAP_FAILED;
+            if (ok) run.base = static_cast<const unsigned char*>(data);
+        }
+        ::close(fd);
+        if (!ok || std::memcmp(run.base, "S2TX", 4) != 0) {
+            unmap(run);
+            return false;
+        }
+        const unsigned char* p = run.base + 4;
+        run.terms = static_cast<uint32_t>(getFixed(p, 4));
+        uint64_t first = getFixed(p, 8);
+        uint64_t end = getFixed(p, 8);
+        run.dictOffset = getFixed(p, 8);
+        run.offsetsOffset = getFixed(p, 8);
+        if (first != run.first || end != run.end || !validate(run)) {
+            unmap(run);
+            return false;
+        }
+        return true;
+    }
+
+    // Checks that the offset table, every dictionary entry and every
+    // postings list lie inside the file, so a torn or corrupt run is
+    // rejected here instead of being read out of bounds by a search.
+    static bool validate(const Run& run) {
+        if (run.dictOffset < HEADER_BYTES || run.dictOffset > run.offsetsOffset ||
+            run.offsetsOffset > run.size || (run.size - run.offsetsOffset) / 8 < run.terms) {
+            return false;
+        }
+        const uint64_t dictBytes = run.offsetsOffset - run.dictOffset;
+        const uint64_t blobBytes = run.dictOffset - HEADER_BYTES;
+        for (uint32_t i = 0; i < run.terms; i++) {
+            const unsigned char* o = run.base + run.offsetsOffset + 8 * static_cast<size_t>(i);
+            uint64_t at = getFixed(o, 8);
+            if (at > dictBytes || dictBytes - at < 2) return false;
+            const unsigned char* p = run.base + run.dictOffset + at;
+            uint64_t length = getFixed(p, 2);
+            if (dictBytes - at - 2 < length + 28) return false;   // term, then 4 + 8 + 8 + 8 bytes
+            p += length + 12;
+            uint64_t offset = getFixed(p, 8);
+            uint64_t bytes = getFixed(p, 8);
+            if (offset > blobBytes || bytes > blobBytes - offset) return false;
+        }
+        return true;
+    }
+
+    static void unmap(Run& run) {
+        if (run.base) munmap(const_cast<unsigned char*>(run.base), run.size);
+        run.base = nullptr;
+    }
+
+    // Dictionary entry `i` of a run.
+    static DictEntry entryAt(const Run& run, uint32_t i) {
+        const unsigned char* o = run.base + run.offsetsOffset + 8 * static_cast<size_t>(i);
+        const unsigned char* p = run.base + run.dictOffset + getFixed(o, 8);
+        DictEntry entry;
+        size_t length = static_cast<size_t>(getFixed(p, 2));
+        entry.term.assign(reinterpret_cast<const char*>(p), length);
+        p += length;
+        entry.segments = static_cast<uint32_t>(getFixed(p, 4));
+        entry.lastSegment = getFixed(p, 8);
+        entry.offset = getFixed(p, 8);
+        entry.bytes = getFixed(p, 8);
+        return entry;
+    }
+
+    static bool find(const Run& run, const std::string& term, DictEntry& out) {
+        uint32_t low = 0, high = run.terms;
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            const unsigned char* o = run.base + run.offsetsOffset + 8 * static_cast<size_t>(mid);
+            const unsigned char* p = run.base + run.dictOffset + getFixed(o, 8);
+            size_t length = static_cast<size_t>(getFixed(p, 2));
+            int cmp = term.compare(0, std::string::npos, reinterpret_cast<const char*>(p), length);
+            if (cmp == 0) {
+                out = entryAt(run, mid);
+                return true;
+            }
+            if (cmp < 0) high = mid; else low = mid + 1;
+        }
+        return false;
+    }
+
+    // Positions are only kept for phrase queries; otherwise they are skipped.
+    static void decode(const unsigned char* p, const unsigned char* end, PostingList& list, bool withPositions) {
+        uint64_t segment = 0;
+        while (p < end) {
+            segment += getVarint(p);
+            uint32_t count = static_cast<uint32_t>(getVarint(p));
+            list.segments.push_back({segment, static_cast<uint32_t>(list.positions.size()), count});
+            if (!withPositions) {
+                for (uint32_t i = 0; i < count; i++) {
+                    while (*p++ & 0x80) {}
+                }
+                continue;
+            }
+            uint32_t position = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                position += static_cast<uint32_t>(getVarint(p));
+                list.positions.push_back(position);
+            }
+        }
+    }
+
+    // Postings of `term` over all runs and the delta, in segment order.
+    void collect(const std::string& term, PostingList& list, bool withPositions) const {
+        for (const Run& run : runs) {
+            DictEntry entry;
+            if (find(run, term, entry)) {
+                const unsigned char* p = run.base + HEADER_BYTES + entry.offset;
+                decode(p, p + entry.bytes, list, withPositions);
+            }
+        }
+        auto it = delta.find(term);
+        if (it != delta.end()) {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(it->second.bytes.data());
+            decode(p, p + it->second.bytes.size(), list, withPositions);
+        }
+    }
+
+    static bool matchesPhrase(uint64_t segment, const std::vector<std::string>& terms,
+                              std::unordered_map<std::string, PostingList>& lists) {
+        auto positionsOf = [&](const std::string& term, const uint32_t*& begin, const uint32_t*& end) {
+            const PostingList& list = lists[term];
+            auto it = std::lower_bound(list.segments.begin(), list.segments.end(), segment,
+                                       [](const Posting& p, uint64_t s) { return p.segment < s; });
+            begin = list.positions.data() + it->firstPosition;
+            end = begin + it->positionCount;
+        };
+        const uint32_t* startBegin;
+        const uint32_t* startEnd;
+        positionsOf(terms[0], startBegin, startEnd);
+        for (const uint32_t* start = startBegin; start != startEnd; ++start) {
+            bool all = true;
+            for (size_t k = 1; k < terms.size() && all; k++) {
+                const uint32_t* begin;
+                const uint32_t* end;
+                positionsOf(terms[k], begin, end);
+                all = std::binary_search(begin, end, *start + static_cast<uint32_t>(k));
+            }
+            if (all) return true;
+        }
+        return false;
+    }
+
+    std::string runPath(uint64_t first, uint64_t end) const {
+        char name[64];
+        snprintf(name, sizeof(name), "/run-%012llu-%012llu.idx", static_cast<unsigned long long>(first),
+                 static_cast<unsigned long long>(end));
+        return directory + name;
+    }
+
+    // Writes to a temporary file, fsyncs and renames into place.
+    bool writeRun(uint64_t first, uint64_t end, const std::string& blob, const std::vector<DictEntry>& dictionary) {
+        std::string dict;
+        std::string offsets;
+        for (const DictEntry& entry : dictionary) {
+            putFixed(offsets, dict.size(), 8);
+            putFixed(dict, entry.term.size(), 2);
+            dict += entry.term;
+            putFixed(dict, entry.segments, 4);
+            putFixed(dict, entry.lastSegment, 8);
+            putFixed(dict, entry.offset, 8);
+            putFixed(dict, entry.bytes, 8);
+        }
+        std::string header = "S2TX";
+        putFixed(header, dictionary.size(), 4);
+        putFixed(header, first, 8);
+        putFixed(header, end, 8);
+        uint64_t dictOffset = HEADER_BYTES + blob.size();
+        putFixed(header, dictOffset, 8);
+        putFixed(header, dictOffset + dict.size(), 8);
+
+        Run run;
+        run.path = runPath(first, end);
+        run.first = first;
+        run.end = end;
+        std::string temporary = run.path + ".tmp";
+        int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        writeAll(fd, header.data(), header.size());
+        writeAll(fd, blob.data(), blob.size());
+        writeAll(fd, dict.data(), dict.size());
+        writeAll(fd, offsets.data(), offsets.size());
+        fsync(fd);
+        ::close(fd);
+        if (rename(temporary.c_str(), run.path.c_str()) != 0 || !map(run)) {
+            unlink(temporary.c_str());
+            return false;
+        }
+        runs.push_back(run);
+        coveredEnd = end;
+        return true;
+    }
+
+    // Merges the two newest (adjacent) runs. Their postings are concatenated
+    // per term; only the first segment delta of the newer list is re-coded.
+    bool mergeLastTwo() {
+        Run older = runs[runs.size() - 2];
+        Run newer = runs.back();
+        std::string blob;
+        std::vector<DictEntry> dictionary;
+        uint32_t i = 0, j = 0;
+        while (i < older.terms || j < newer.terms) {
+            DictEntry a, b;
+            if (i < older.terms) a = entryAt(older, i);
+            if (j < newer.terms) b = entryAt(newer, j);
+            bool takeA = i < older.terms && (j >= newer.terms || a.term <= b.term);
+            bool takeB = j < newer.terms && (i >= older.terms || b.term <= a.term);
+            DictEntry merged;
+            merged.term = takeA ? a.term : b.term;
+            merged.offset = blob.size();
+            merged.segments = 0;
+            uint64_t last = 0;
+            if (takeA) {
+                blob.append(reinterpret_cast<const char*>(older.base + HEADER_BYTES + a.offset), a.bytes);
+                merged.segments += a.segments;
+                last = a.lastSegment;
+                i++;
+            }
+            if (takeB) {
+                const unsigned char* p = newer.base + HEADER_BYTES + b.offset;
+                const unsigned char* end = p + b.bytes;
+                uint64_t firstSegment = getVarint(p);
+                putVarint(blob, firstSegment - last);
+                blob.append(reinterpret_cast<const char*>(p), end - p);
+                merged.segments += b.segments;
+                last = b.lastSegment;
+                j++;
+            }
+            merged.lastSegment = last;
+            merged.bytes = blob.size() - merged.offset;
+            dictionary.push_back(std::move(merged));
+        }
+        runs.pop_back();
+        runs.pop_back();
+        if (!writeRun(older.first, newer.end, blob, dictionary)) {
+            runs.push_back(older);
+            runs.push_back(newer);
+            return false;
+        }
+        unmap(older);
+        unmap(newer);
+        unlink(older.path.c_str());
+        unlink(newer.path.c_str());
+        return true;
+    }
+};
+
+// Indexes final segments on a background thread, so the log fsyncs and run
+// writes never touch the capture loop. The delta is written as a run every
+// `flushEvery` segments and when the worker stops.
+class TranscriptIndexer {
+public:
+    ~TranscriptIndexer() {
+        stop();
+    }
+
+    bool start(const std::string& directory, const std::string& archive, int sampleRate, size_t flushEvery) {
+        stop();
+        if (!index.open(directory, true)) {
+            std::cerr << "⚠️ Transcript index unavailable: " << directory << std::endl;
+            return false;
+        }
+        session = index.beginSession(archive, sampleRate);
+        flushInterval = std::max<size_t>(1, flushEvery);
+        sinceFlush = 0;
+        segments = 0;
+        busyMicros = 0.0;
+        stopping = false;
+        running = true;
+        worker = std::thread(&TranscriptIndexer::run, this);
+        return true;
+    }
+
+    bool active() const { return running; }
+
+    void submit(const StreamRange& range, const std::string& language, const std::string& text) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back({range, language, text});
+        }
+        wake.notify_one();
+    }
+
+    // Indexes everything submitted so far, writes the last run and stops.
+    void stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+        index.flush();
+        running = false;
+    }
+
+    void report() const {
+        if (segments == 0) return;
+        std::cout << "🔎 Indexed " << segments << " segments (" << (busyMicros / segments / 1000.0)
+                  << " ms each incl. fsync), " << index.segmentCount() << " in the index, "
+                  << index.runCount() << " runs" << std::endl;
+    }
+
+private:
+    struct Segment {
+        StreamRange range;
+        std::string language;
+        std::string text;
+    };
+
+    TranscriptIndex index;
+    uint32_t session = 0;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Segment> pending;
+    size_t flushInterval = 256;
+    size_t sinceFlush = 0;
+    bool stopping = false;
+    bool running = false;
+    uint64_t segments = 0;
+    double busyMicros = 0.0;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) return;
+            Segment segment = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+
+            auto begin = std::chrono::steady_clock::now();
+            index.add(session, segment.range, segment.language, segment.text);
+            if (++sinceFlush >= flushInterval) {
+                index.flush();
+                sinceFlush = 0;
+            }
+            busyMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+            segments++;
+
+            lock.lock();
+        }
+    }
+};
@@ -0,0 +1,482 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "nbest.h"
+#include "recorder_settings.h"
+#include "task_scheduler.h"
+#include "vosk-linux-x86_64-0.3.45/vosk_api.h"
+
+// Decodes one client stream. Called by one worker at a time.
+class StreamDecoder {
+public:
+    virtual ~StreamDecoder() = default;
+    // Returns true and sets `text` when the chunk ended an utterance.
+    virtual bool accept(const int16_t* samples, size_t count, std::string& text) = 0;
+    virtual void finish(std::string& text) = 0;
+};
+
+class VoskStreamDecoder : public StreamDecoder {
+public:
+    explicit VoskStreamDecoder(VoskRecognizer* recognizer) : recognizer(recognizer) {}
+
+    ~VoskStreamDecoder() override {
+        vosk_recognizer_free(recognizer);
+    }
+
+    bool accept(const int16_t* samples, size_t count, std::string& text) override {
+        if (!vosk_recognizer_accept_waveform_s(recognizer, samples, static_cast<int>(count))) return false;
+        return read(vosk_recognizer_result(recognizer), text);
+    }
+
+    void finish(std::string& text) override {
+        read(vosk_recognizer_final_result(recognizer), text);
+    }
+
+private:
+    VoskRecognizer* recognizer;
+    std::vector<Hypothesis> hypotheses;
+
+    bool read(const char* json, std::string& text) {
+        if (ResultParser::parse(json, hypotheses) == 0) return false;
+        text = hypotheses[0].text;
+        return true;
+    }
+};
+
+// Used when no model is loaded, so the server and its clients can be
+// exercised anywhere: burns CPU in proportion to the audio and ends an
+// utterance every few seconds.
+class StandInStreamDecoder : public StreamDecoder {
+public:
+    StandInStreamDecoder(int sampleRate, double rtf) : sampleRate(sampleRate), rtf(rtf) {}
+
+    bool accept(const int16_t* samples, size_t count, std::string& text) override {
+        (void)samples;
+        auto until = std::chrono::steady_clock::now()
+                   + std::chrono::duration<double>(rtf * count / sampleRate);
+        while (std::chrono::steady_clock::now() < until) {}
+        sinceFinal += count;
+        if (sinceFinal < static_cast<size_t>(sampleRate) * UTTERANCE_SECONDS) return false;
+        sinceFinal = 0;
+        text = "utterance " + std::to_string(++utterances);
+        return true;
+    }
+
+    void finish(std::string& text) override {
+        if (sinceFinal > 0) text = "utterance " + std::to_string(++utterances);
+    }
+
+private:
+    static constexpr size_t UTTERANCE_SECONDS = 3;
+    int sampleRate;
+    double rtf;
+    size_t sinceFinal = 0;
+    uint64_t utterances = 0;
+};
+
+// Local transcription server: many clients stream PCM over a Unix socket
+// and get their transcripts back.
+//
+// Protocol, one connection per stream:
+//   client -> "pcm <sample-rate> [model-path]\n", then s16le mono PCM;
+//             shutdown(SHUT_WR) ends the stream
+//   server -> "final <text>\n" per utterance, then
+//             "done audio=<s> rtf=<x> max-queue=<chunks>\n" and closes
+// A connection that sends "stats\n" instead gets one line per open session:
+//   "session <id> audio=<s> rtf=<x> max-queue=<chunks> queue=<chunks>"
+//
+// One I/O thread polls all sockets and cuts the input into chunks of
+// server-chunk-ms. The chunks are decoded on the shared TaskScheduler: a
+// session with queued chunks has exactly one step task in flight, which
+// decodes one chunk and re-submits itself behind the other sessions on the
+// same worker, so every stream gets the same share of decode time no matter
+// how fast it sends, its recognizer stays on one thread at a time, and
+// idle workers steal waiting sessions from busy ones. A client more than
+// server-max-queue chunks ahead is not read until the workers catch up, so
+// a fast sender cannot grow memory without bound.
+//
+// Models are shared: recognizers for the same model path use one
+// VoskModel, loaded on first use by a worker (not the I/O thread).
+class TranscriptionServer {
+public:
+    // The scheduler must be running; the server uses its workers but
+    // leaves starting and stopping it to the caller.
+    TranscriptionServer(VoskModel* defaultModel, TaskScheduler& scheduler)
+        : defaultModel(defaultModel), scheduler(scheduler) {}
+
+    ~TranscriptionServer() {
+        for (auto& [path, model] : models) vosk_model_free(model);
+    }
+
+    // Serves until `stop()` returns true (checked at least every 100 ms).
+    bool run(const std::string& socketPath, const RecorderSettings& settings, const std::function<bool()>& stop) {
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(socketPath.c_str());
+        if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listenFd, 64) != 0) {
+            std::cerr << "❌ Server socket unavailable: " << socketPath << " (" << strerror(errno) << ")" << std::endl;
+            if (listenFd >= 0) ::close(listenFd);
+            return false;
+        }
+        if (pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+            ::close(listenFd);
+            return false;
+        }
+
+        chunkMs = std::max(10, settings.serverChunkMs);
+        maxQueue = std::max<size_t>(1, settings.serverMaxQueue);
+        standInRtf = settings.serverStandInRtf;
+        stopping = false;
+        std::cout << "🖧 Serving on " << socketPath << " with " << scheduler.workerCount() << " workers, "
+                  << chunkMs << " ms chunks" << (defaultModel ? "" : " (no model: stand-in decoder)")
+                  << std::endl;
+
+        auto lastReport = std::chrono::steady_clock::now();
+        while (!stop()) {
+            pollOnce();
+            auto now = std::chrono::steady_clock::now();
+            if (settings.serverReportSeconds > 0 &&
+                now - lastReport >= std::chrono::seconds(settings.serverReportSeconds)) {
+                std::istringstream report(stats());
+                std::string line;
+                while (std::getline(report, line)) std::cout << "🖧 " << line << std::endl;
+                lastReport = now;
+            }
+        }
+
+        // Steps in flight finish their chunk and do not re-submit
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            stopping = true;
+            idle.wait(lock, [this] { return inFlight == 0; });
+        }
+        for (auto& [id, session] : sessions) ::close(session->fd);
+        sessions.clear();
+        ::close(listenFd);
+        ::close(wakePipe[0]);
+        ::close(wakePipe[1]);
+        unlink(socketPath.c_str());
+        return true;
+    }
+
+private:
+    struct Session {
+        uint32_t id = 0;
+        int fd = -1;
+        std::string input;                    // I/O thread: header, then unchunked bytes
+        bool headerDone = false;
+        bool statsOnly = false;
+        int sampleRate = 16000;
+        std::string modelPath;
+        size_t chunkBytes = 3200;
+        std::chrono::steady_clock::time_point opened;
+
+        // Guarded by the server mutex
+        std::deque<std::vector<int16_t>> queue;
+        std::string outbox;
+        bool inputClosed = false;
+        bool scheduled = false;               // a step task is queued or running
+        bool finished = false;
+        size_t maxDepth = 0;
+        uint64_t samples = 0;
+        double decodeSeconds = 0.0;
+
+        std::unique_ptr<StreamDecoder> decoder;   // the worker holding the session only
+    };
+
+    VoskModel* defaultModel;
+    TaskScheduler& scheduler;
+    std::map<std::string, VoskModel*> models;     // guarded by modelMutex
+    std::mutex modelMutex;
+
+    int listenFd = -1;
+    int wakePipe[2] = {-1, -1};
+    int chunkMs = 100;
+    size_t maxQueue = 50;
+    double standInRtf = 0.1;
+    uint32_t nextId = 0;
+
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::map<uint32_t, std::unique_ptr<Session>> sessions;
+    size_t inFlight = 0;                  // scheduled sessions
+    bool stopping = false;
+
+    void wake() {
+        char byte = 1;
+        if (write(wakePipe[1], &byte, 1) < 0) {}   // full pipe: a wake-up is already pending
+    }
+
+    // Caller holds the mutex.
+    void schedule(Session& session) {
+        if (session.scheduled || session.finished || stopping) return;
+        if (session.queue.empty() && !session.inputClosed) return;
+        session.scheduled = true;
+        inFlight++;
+        scheduler.submit([this, &session] { step(session); });
+    }
+
+    void pollOnce() {
+        std::vector<pollfd> fds;
+        std::vector<Session*> owners;
+        fds.push_back({listenFd, POLLIN, 0});
+        fds.push_back({wakePipe[0], POLLIN, 0});
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& [id, session] : sessions) {
+                short events = 0;
+                if (!session->inputClosed && session->queue.size() < maxQueue) events |= POLLIN;
+                if (!session->outbox.empty()) events |= POLLOUT;
+                fds.push_back({session->fd, events, 0});
+                owners.push_back(session.get());
+            }
+        }
+        if (poll(fds.data(), fds.size(), 100) <= 0) return;
+
+        if (fds[1].revents & POLLIN) {
+            char drain[64];
+            while (read(wakePipe[0], drain, sizeof(drain)) > 0) {}
+        }
+        if (fds[0].revents & POLLIN) accept();
+        for (size_t i = 2; i < fds.size(); i++) {
+            Session& session = *owners[i - 2];
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) receive(session);
+            if (fds[i].revents & POLLOUT) send(session);
+        }
+        reap();
+    }
+
+    void accept() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            auto session = std::make_unique<Session>();
+            session->id = nextId++;
+            session->fd = fd;
+            session->opened = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> lock(mutex);
+            sessions[session->id] = std::move(session);
+        }
+    }
+
+    void receive(Session& session) {
+        char buffer[16384];
+        while (true) {
+            ssize_t n = read(session.fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                session.input.append(buffer, static_cast<size_t>(n));
+                if (!session.headerDone && !parseHeader(session)) return;
+                if (session.headerDone) enqueueChunks(session, false);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (session.queue.size() >= maxQueue) return;   // back-pressure
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EINTR)) return;
+            // End of stream (or error): decode what is left and finish
+            if (session.headerDone) enqueueChunks(session, true);
+            std::lock_guard<std::mutex> lock(mutex);
+            session.inputClosed = true;
+            if (!session.headerDone) session.finished = true;
+            schedule(session);
+            return;
+        }
+    }
+
+    bool parseHeader(Session& session) {
+        size_t newline = session.input.find('\n');
+        if (newline == std::string::npos) {
+            if (session.input.size() > 4096) reject(session, "header too long");
+            return false;
+        }
+        std::string header = session.input.substr(0, newline);
+        session.input.erase(0, newline + 1);
+        if (header == "stats") {
+            std::string report = stats();
+            std::lock_guard<std::mutex> lock(mutex);
+            session.outbox = report.empty() ? "no sessions\n" : report;
+            session.statsOnly = true;
+            session.inputClosed = true;
+            session.finished = true;
+            return false;
+        }
+        char path[1024] = "";
+        int rate = 0;
+        if (sscanf(header.c_str(), "pcm %d %1023s", &rate, path) < 1 || rate < 8000 || rate > 48000) {
+            reject(session, "expected \"pcm <sample-rate> [model-path]\"");
+            return false;
+        }
+        session.sampleRate = rate;
+        session.modelPath = path;
+        session.chunkBytes = static_cast<size_t>(rate) * chunkMs / 1000 * sizeof(int16_t);
+        session.headerDone = true;
+        return true;
+    }
+
+    void reject(Session& session, const std::string& reason) {
+        std::lock_guard<std::mutex> lock(mutex);
+        session.outbox = "error " + reason + "\n";
+        session.inputClosed = true;
+        session.finished = true;
+    }
+
+    void enqueueChunks(Session& session, bool all) {
+        size_t offset = 0;
+        std::lock_guard<std::mutex> lock(mutex);
+        while (session.input.size() - offset >= session.chunkBytes ||
+               (all && session.input.size() - offset >= sizeof(int16_t))) {
+            size_t bytes = std::min(session.chunkBytes, session.input.size() - offset);
+            bytes -= bytes % sizeof(int16_t);
+            std::vector<int16_t> chunk(bytes / sizeof(int16_t));
+            memcpy(chunk.data(), session.input.data() + offset, bytes);
+            offset += bytes;
+            session.queue.push_back(std::move(chunk));
+            session.maxDepth = std::max(session.maxDepth, session.queue.size());
+        }
+        session.input.erase(0, offset);
+        schedule(session);
+    }
+
+    void send(Session& session) {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!session.outbox.empty()) {
+            ssize_t n = ::send(session.fd, session.outbox.data(), session.outbox.size(), MSG_NOSIGNAL);
+            if (n <= 0) {
+                if (n < 0 && errno != EAGAIN && errno != EINTR) session.outbox.clear();   // client went away
+                return;
+            }
+            session.outbox.erase(0, static_cast<size_t>(n));
+        }
+    }
+
+    // Closes sessions that are done and fully sent.
+    void reap() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            Session& session = *it->second;
+            if (session.finished && !session.scheduled && session.outbox.empty()) {
+                if (!session.statsOnly && session.samples > 0) {
+                    std::cout << "🖧 #" << session.id << " done: " << summary(session) << std::endl;
+                }
+                ::close(session.fd);
+                it = sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    static std::string summary(const Session& session) {
+        double audio = static_cast<double>(session.samples) / session.sampleRate;
+        char line[128];
+        snprintf(line, sizeof(line), "audio=%.2f rtf=%.3f max-queue=%zu", audio,
+                 audio > 0 ? session.decodeSeconds / audio : 0.0, session.maxDepth);
+        return line;
+    }
+
+    std::string stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string out;
+        for (auto& [id, session] : sessions) {
+            if (session->statsOnly || !session->headerDone) continue;
+            out += "session " + std::to_string(id) + " " + summary(*session) + " queue="
+                 + std::to_string(session->queue.size()) + "\n";
+        }
+        return out;
+    }
+
+    // Decodes one chunk of the session (or finishes it), then schedules
+    // the next step if there is more.
+    void step(Session& session) {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::vector<int16_t> chunk;
+        bool wasFull = session.queue.size() >= maxQueue;
+        bool hasChunk = !session.queue.empty();
+        if (hasChunk) {
+            chunk = std::move(session.queue.front());
+            session.queue.pop_front();
+        }
+        bool closing = !hasChunk && session.inputClosed;
+        lock.unlock();
+
+        std::string output;
+        auto begin = std::chrono::steady_clock::now();
+        if (!session.decoder) open(session, output);
+        std::string text;
+        if (session.decoder && hasChunk && session.decoder->accept(chunk.data(), chunk.size(), text)) {
+            output += "final " + text + "\n";
+        }
+        if (session.decoder && closing) {
+            text.clear();
+            session.decoder->finish(text);
+            if (!text.empty()) output += "final " + text + "\n";
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        lock.lock();
+        session.samples += chunk.size();
+        session.decodeSeconds += seconds;
+        if (closing || !session.decoder) {
+            session.finished = true;
+            if (session.decoder) output += "done " + summary(session) + "\n";
+            session.decoder.reset();
+        }
+        session.outbox += output;
+        session.scheduled = false;
+        inFlight--;
+        schedule(session);
+        if (inFlight == 0) idle.notify_all();
+        if (!output.empty() || session.finished || wasFull) wake();
+    }
+
+    // Creates the session's decoder on the worker, loading its model once.
+    void open(Session& session, std::string& output) {
+        VoskModel* model = defaultModel;
+        if (!session.modelPath.empty()) {
+            std::lock_guard<std::mutex> lock(modelMutex);
+            auto it = models.find(session.modelPath);
+            if (it == models.end()) {
+                model = vosk_model_new(session.modelPath.c_str());
+                if (model) models[session.modelPath] = model;
+            } else {
+                model = it->second;
+            }
+            if (!model) {
+                output += "error model could not be loaded: " + session.modelPath + "\n";
+                return;
+            }
+        }
+        if (!model) {
+            session.decoder = std::make_unique<StandInStreamDecoder>(session.sampleRate, standInRtf);
+            return;
+        }
+        VoskRecognizer* recognizer = vosk_recognizer_new(model, static_cast<float>(session.sampleRate));
+        if (!recognizer) {
+            output += "error recognizer could not be created\n";
+            return;
+        }
+        session.decoder = std::make_unique<VoskStreamDecoder>(recognizer);
+    }
+};
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "recorder_settings.h"
+#include "vocabulary.h"
+
+// Translates a batch of final segments. The whole batch is handed over in
+// one call so a model with a fixed cost per call (a neural model's forward
+// pass) can amortize it. Implementations are called from the translation
+// worker only, so they need no locking of their own.
+class TranslationModel {
+public:
+    virtual ~TranslationModel() = default;
+    virtual const char* name() const = 0;
+    virtual void translate(const std::vector<std::string>& sources, std::vector<std::string>& out) = 0;
+    // Called before each batch; true when the model changed, which makes
+    // cached translations stale.
+    virtual bool refresh() { return false; }
+};
+
+// Phrase-table translation: "source phrase -> target phrase" lines, matched
+// longest-first with the vocabulary trie. Words without an entry are copied
+// through, which is what names and numbers want anyway. Punctuation from
+// the punctuation stage is stripped before matching; the sentence mark is
+// put back and the first letter capitalized if the source's was.
+class PhraseTableModel : public TranslationModel {
+public:
+    explicit PhraseTableModel(const std::string& path) : path(path), table("Phrase table") {}
+
+    bool load() {
+        table.reloadIfChanged(path, 0.0, nullptr);
+        return !table.empty();
+    }
+
+    const char* name() const override { return "phrase table"; }
+
+    bool refresh() override {
+        return table.reloadIfChanged(path, 0.0, nullptr);
+    }
+
+    void translate(const std::vector<std::string>& sources, std::vector<std::string>& out) override {
+        out.resize(sources.size());
+        for (size_t i = 0; i < sources.size(); i++) {
+            translateOne(sources[i], out[i]);
+        }
+    }
+
+private:
+    std::string path;
+    Vocabulary table;
+    std::string plain;   // scratch
+
+    void translateOne(const std::string& source, std::string& out) {
+        plain.clear();
+        for (char c : source) {
+            if (c == '.' || c == ',' || c == '?' || c == '!' || c == ';' || c == ':') continue;
+            plain += c;
+        }
+        table.rewrite(plain, out);
+        if (out.empty()) return;
+        unsigned char first = source[0];
+        if (first < 0x80 && std::isupper(first)) {
+            out[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(out[0])));
+        }
+        char mark = source.back();
+        if (mark == '.' || mark == '?' || mark == '!') out += mark;
+    }
+};
+
+// Stand-in for a neural model, for measuring the stage without shipping
+// one: burns a fixed CPU cost per call plus a cost per word, and tags the
+// text with the target language instead of translating it.
+class StandInModel : public TranslationModel {
+public:
+    StandInModel(const std::string& target, double callMs, double wordMs)
+        : tag("[" + target + "] "), callCost(callMs), wordCost(wordMs) {}
+
+    const char* name() const override { return "stand-in"; }
+
+    void translate(const std::vector<std::string>& sources, std::vector<std::string>& out) override {
+        size_t words = 0;
+        for (const std::string& source : sources) {
+            words += 1 + std::count(source.begin(), source.end(), ' ');
+        }
+        spin(callCost + wordCost * words);
+        out.resize(sources.size());
+        for (size_t i = 0; i < sources.size(); i++) {
+            out[i] = tag + sources[i];
+        }
+    }
+
+private:
+    std::string tag;
+    double callCost;
+    double wordCost;
+
+    static void spin(double ms) {
+        auto until = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(ms);
+        while (std::chrono::steady_clock::now() < until) {}
+    }
+};
+
+// Least-recently-used map from source segment to its translation. Keys are
+// views into the list nodes, so each string is stored once.
+class TranslationCache {
+public:
+    void reset(size_t entries) {
+        clear();
+        capacity = entries;
+        index.reserve(entries);
+    }
+
+    void clear() {
+        index.clear();
+        items.clear();
+    }
+
+    // Marks the entry as most recently used.
+    const std::string* find(const std::string& source) {
+        auto it = index.find(std::string_view(source));
+        if (it == index.end()) return nullptr;
+        items.splice(items.begin(), items, it->second);
+        return &it->second->second;
+    }
+
+    void insert(const std::string& source, const std::string& translation) {
+        if (capacity == 0 || index.count(std::string_view(source))) return;
+        if (items.size() == capacity) {
+            index.erase(std::string_view(items.back().first));
+            items.pop_back();
+        }
+        items.emplace_front(source, translation);
+        index.emplace(std::string_view(items.front().first), items.begin());
+    }
+
+private:
+    using Item = std::pair<std::string, std::string>;
+    std::list<Item> items;   // most recent first
+    std::unordered_map<std::string_view, std::list<Item>::iterator> index;
+    size_t capacity = 0;
+};
+
+// Translates final segments off the capture thread.
+//
+// Like the punctuation worker, each wake-up takes everything queued (up to
+// `maxBatch` segments), so under load the model sees full batches and idle
+// segments go out alone. Cache hits and segments already in the target
+// language never reach the model; repeated segments within one batch are
+// translated once. Results come back in submission order via poll().
+class TranslationWorker {
+public:
+    ~TranslationWorker() {
+        stop();
+    }
+
+    // "phrases" reads translation-table (default translation-<src>-<tgt>.txt
+    // next to the binary); "stand-in" is the benchmark model.
+    static std::unique_ptr<TranslationModel> create(const RecorderSettings& settings) {
+        if (settings.translationModel == "phrases") {
+            std::string path = settings.translationTable;
+            if (path.empty()) {
+                path = "translation-" + languageCode(sourceLanguage(settings)) + "-"
+                     + languageCode(settings.translationTarget) + ".txt";
+            }
+            auto model = std::make_unique<PhraseTableModel>(path);
+            if (model->load()) {
+                return model;
+            }
+            std::cerr << "⚠️ Translation: no phrase table at " << path << ", translation off" << std::endl;
+        } else if (settings.translationModel == "stand-in") {
+            return std::make_unique<StandInModel>(languageCode(settings.translationTarget), 4.0, 0.5);
+        } else {
+            std::cerr << "⚠️ Unknown translation model: " << settings.translationModel << std::endl;
+        }
+        return nullptr;
+    }
+
+    static std::string sourceLanguage(const RecorderSettings& settings) {
+        return settings.translationSource.empty() ? settings.textLanguage : settings.translationSource;
+    }
+
+    // "en-US" -> "en"
+    static std::string languageCode(const std::string& language) {
+        return language.substr(0, 2);
+    }
+
+    void start(std::unique_ptr<TranslationModel> instance, size_t maxBatch, size_t cacheEntries,
+               const std::string& targetLanguage) {
+        stop();
+        model = std::move(instance);
+        if (!model) return;
+        batchLimit = std::max<size_t>(1, maxBatch);
+        cache.reset(cacheEntries);
+        target = languageCode(targetLanguage);
+        segments = 0;
+        hits = 0;
+        passed = 0;
+        calls = 0;
+        modelMicros = 0.0;
+        latenciesMs.clear();
+        stopping = false;
+        worker = std::thread(&TranslationWorker::run, this);
+    }
+
+    bool active() const { return model != nullptr; }
+
+    void submit(const std::string& text, const std::string& language) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back({text, languageCode(language), std::chrono::steady_clock::now()});
+        }
+        wake.notify_one();
+    }
+
+    template <typename Emit>
+    void poll(Emit&& emit) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (done.empty()) return;
+            delivered.swap(done);   // both keep their storage, so polling does not allocate
+        }
+        for (const std::string& text : delivered) {
+            emit(text);
+        }
+        delivered.clear();
+    }
+
+    // Translates everything submitted so far, then stops the thread.
+    void stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    void report() const {
+        if (!model || segments == 0) return;
+        std::vector<double> sorted = latenciesMs;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (double l : sorted) sum += l;
+        std::cout << "🌍 Translation (" << model->name() << "): " << segments << " segments, " << hits
+                  << " cache hits, " << passed << " already in " << target << ", " << calls
+                  << " model calls (" << (calls ? modelMicros / calls / 1000.0 : 0.0)
+                  << " ms each), latency mean " << (sum / sorted.size()) << " ms, p50 "
+                  << sorted[sorted.size() / 2] << " ms, p90 " << sorted[sorted.size() * 9 / 10]
+                  << " ms" << std::endl;
+    }
+
+private:
+    struct Segment {
+        std::string text;
+        std::string language;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    std::unique_ptr<TranslationModel> model;
+    TranslationCache cache;
+    std::string target;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Segment> pending;
+    std::deque<std::string> done;
+    std::deque<std::string> delivered;   // poll() only
+    size_t batchLimit = 8;
+    bool stopping = false;
+
+    uint64_t segments = 0;
+    uint64_t hits = 0;
+    uint64_t passed = 0;
+    uint64_t calls = 0;
+    double modelMicros = 0.0;
+    std::vector<double> latenciesMs;
+
+    void run() {
+        std::vector<Segment> batch;
+        std::vector<std::string> results;
+        std::vector<std::string> misses;
+        std::vector<std::string> translated;
+        std::vector<size_t> missOf;   // batch index -> misses index, or SIZE_MAX
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) return;
+            batch.clear();
+            while (!pending.empty() && batch.size() < batchLimit) {
+                batch.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
+            lock.unlock();
+
+            if (model->refresh()) cache.clear();
+            results.assign(batch.size(), std::string());
+            misses.clear();
+            missOf.assign(batch.size(), SIZE_MAX);
+            for (size_t i = 0; i < batch.size(); i++) {
+                const Segment& segment = batch[i];
+                if (segment.language == target) {
+                    results[i] = segment.text;
+                    passed++;
+                } else if (const std::string* cached = cache.find(segment.text)) {
+                    results[i] = *cached;
+                    hits++;
+                } else {
+                    auto same = std::find(misses.begin(), misses.end(), segment.text);
+                    missOf[i] = same - misses.begin();
+                    if (same == misses.end()) misses.push_back(segment.text);
+                }
+            }
+            if (!misses.empty()) {
+                auto begin = std::chrono::steady_clock::now();
+                model->translate(misses, translated);
+                modelMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+                calls++;
+                for (size_t m = 0; m < misses.size(); m++) {
+                    cache.insert(misses[m], translated[m]);
+                }
+                for (size_t i = 0; i < batch.size(); i++) {
+                    if (missOf[i] != SIZE_MAX) results[i] = translated[missOf[i]];
+                }
+            }
+
+            auto end = std::chrono::steady_clock::now();
+            for (const Segment& segment : batch) {
+                latenciesMs.push_back(std::chrono::duration<double, std::milli>(end - segment.submitted).count());
+            }
+            segments += batch.size();
+
+            lock.lock();
+            for (std::string& text : results) {
+                done.push_back(std::move(text));
+            }
+        }
+    }
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+// Counts operator new calls per thread. The replacement operator new that
+// feeds it is defined once, in audio_recorder.cpp.
+struct AllocationCounter {
+    static inline thread_local uint64_t allocations = 0;
+
+    // Moves what is allocated during its lifetime out of the thread's count
+    // into `bucket`, to keep the recognizer's own allocations apart.
+    class Exclude {
+    public:
+        explicit Exclude(uint64_t& bucket) : bucket(bucket), start(allocations) {}
+        ~Exclude() {
+            uint64_t made = allocations - start;
+            bucket += made;
+            allocations -= made;
+        }
+        Exclude(const Exclude&) = delete;
+        Exclude& operator=(const Exclude&) = delete;
+
+    private:
+        uint64_t& bucket;
+        uint64_t start;
+    };
+};
+
+// Monotonic arena for the strings and parse buffers of one utterance.
+//
+// Allocation bumps a pointer through a list of blocks; deallocation does
+// nothing. reset() (when the utterance's final is emitted) rewinds to the
+// first block but keeps every block, so after the first few utterances the
+// arena has grown to the size it needs and never asks the heap again. A
+// Scope rewinds to where it was opened, for buffers that only live for one
+// chunk, so partial results do not pile up over a long utterance.
+//
+// Strings using the arena (std::pmr::string) must be destroyed, or swapped
+// with a fresh one, before the memory they point into is rewound; clear()
+// and assignment keep the old buffer.
+class UtteranceArena : public std::pmr::memory_resource {
+public:
+    explicit UtteranceArena(size_t blockBytes = 64 * 1024) : blockBytes(blockBytes) {}
+
+    UtteranceArena(const UtteranceArena&) = delete;
+    UtteranceArena& operator=(const UtteranceArena&) = delete;
+
+    struct Mark {
+        size_t block = 0;
+        size_t used = 0;
+    };
+
+    class Scope {
+    public:
+        explicit Scope(UtteranceArena& arena) : arena(arena), mark(arena.mark()) {}
+        ~Scope() { arena.rewind(mark); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        UtteranceArena& arena;
+        Mark mark;
+    };
+
+    Mark mark() const { return {current, used}; }
+
+    void rewind(Mark to) {
+        current = to.block;
+        used = to.used;
+    }
+
+    void reset() {
+        rewind(Mark());
+    }
+
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block& block : blocks) total += block.size;
+        return total;
+    }
+
+    size_t blockCount() const { return blocks.size(); }
+
+    // Most bytes in use at once since the last call.
+    size_t takeHighWater() {
+        size_t peak = highWater;
+        highWater = 0;
+        return peak;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size = 0;
+    };
+
+    size_t blockBytes;
+    std::vector<Block> blocks;
+    size_t current = 0;       // block being filled
+    size_t used = 0;          // bytes used in it
+    size_t highWater = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        while (true) {
+            if (current < blocks.size()) {
+                Block& block = blocks[current];
+                size_t offset = (used + alignment - 1) / alignment * alignment;
+                if (offset + bytes <= block.size) {
+                    used = offset + bytes;
+                    trackHighWater();
+                    return block.data.get() + offset;
+                }
+                if (current + 1 < blocks.size()) {
+                    current++;
+                    used = 0;
+                    continue;
+                }
+            }
+            // Grows only while warming up; kept for every later utterance
+            Block block;
+            block.size = std::max(blockBytes, bytes + alignment);
+            block.data.reset(new std::byte[block.size]);
+            blocks.push_back(std::move(block));
+            current = blocks.size() - 1;
+            used = 0;
+        }
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    void trackHighWater() {
+        size_t inUse = used;
+        for (size_t i = 0; i < current; i++) inUse += blocks[i].size;
+        highWater = std::max(highWater, inUse);
+    }
+};
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
+#include "vosk-linux-x86_64-0.3.45/vosk_api.h"
+
+// User vocabulary: phrases to boost in N-best rescoring and spoken forms to
+// rewrite in final text. One entry per line:
+//
+//   kubernetes 6                  boost a phrase (weight optional)
+//   Visual Studio Code            boost, and write it with this casing
+//   cooper netties -> Kubernetes  rewrite a spoken form the model does produce
+//
+// Keys are stored lowercase in a byte trie, so matching a phrase at a given
+// position costs O(phrase length) with a binary search over at most a few
+// dozen edges per byte, and never allocates. Every word of a key is checked
+// with vosk_model_find_word; a boost on a word the model cannot output can
+// never fire, so those are reported with a hint to add a rewrite instead.
+//
+// reloadIfChanged() re-reads the file only when its mtime changes and then
+// applies the difference: new keys are inserted, removed ones are
+// tombstoned in place and changed weights are updated, so unchanged
+// entries keep their nodes and are not re-checked against the model.
+class Vocabulary {
+public:
+    struct Entry {
+        std::string key;           // lowercase spoken form
+        std::string replacement;   // text written instead, empty = key unchanged
+        double weight = 0.0;
+        bool live = false;
+        bool covered = true;       // every word known to the model
+    };
+
+    // `label` names the file in log lines (the translator reuses this class
+    // for its phrase table).
+    explicit Vocabulary(const char* label = "Vocabulary") : label(label) {
+        nodes.emplace_back();
+    }
+
+    bool empty() const { return liveEntries == 0; }
+
+    bool reloadIfChanged(const std::string& path, double defaultWeight, VoskModel* model) {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            if (loadedStamp != 0) clear();
+            return false;
+        }
+        int64_t stamp = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+        if (stamp == loadedStamp) return false;
+        loadedStamp = stamp;
+
+        std::ifstream file(path);
+        std::unordered_map<std::string, Entry> wanted;
+        std::string line;
+        while (std::getline(file, line)) {
+            Entry entry;
+            if (parseLine(line, defaultWeight, entry)) {
+                wanted[entry.key] = entry;
+            }
+        }
+
+        size_t added = 0, removed = 0, changed = 0;
+        for (size_t id = 0; id < entries.size(); id++) {
+            Entry& entry = entries[id];
+            if (!entry.live) continue;
+            auto it = wanted.find(entry.key);
+            if (it == wanted.end()) {
+                entry.live = false;
+                removed++;
+            } else if (it->second.weight != entry.weight || it->second.replacement != entry.replacement) {
+                entry.weight = it->second.weight;
+                entry.replacement = it->second.replacement;
+                changed++;
+            }
+        }
+        for (auto& [key, entry] : wanted) {
+            auto known = index.find(key);
+            if (known != index.end()) {
+                Entry& existing = entries[known->second];
+                if (!existing.live) {
+                    existing.live = true;
+                    existing.weight = entry.weight;
+                    existing.replacement = entry.replacement;
+                    added++;
+                }
+                continue;
+            }
+            entry.live = true;
+            entry.covered = checkCoverage(entry.key, model);
+            if (!entry.covered && entry.replacement.empty()) {
+                std::cerr << "⚠️ " << label << ": \"" << entry.key << "\" has words the model does not know; "
+                          << "add a rewrite like \"<what it hears> -> " << entry.key << "\"" << std::endl;
+            }
+            uint32_t id = static_cast<uint32_t>(entries.size());
+            entries.push_back(entry);
+            index[key] = id;
+            insert(key, id);
+            added++;
+        }
+
+        liveEntries = 0;
+        size_t uncovered = 0;
+        for (const Entry& entry : entries) {
+            if (!entry.live) continue;
+            liveEntries++;
+            if (!entry.covered) uncovered++;
+        }
+        std::cout << "📚 " << label << ": " << liveEntries << " entries (+" << added << " -" << removed
+                  << " ~" << changed << "), " << uncovered << " not covered by the model" << std::endl;
+        return true;
+    }
+
+    // Longest live entry whose key matches `text` at `pos` and ends on a word
+    // boundary. Returns the entry index or -1; `matchLength` gets its length.
+    int matchAt(const std::string& text, size_t pos, size_t& matchLength) const {
+        int best = -1;
+        uint32_t node = 0;
+        for (size_t i = pos; i < text.size(); i++) {
+            node = child(node, static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(text[i]))));
+            if (node == NONE) break;
+            int32_t id = nodes[node].entry;
+            if (id >= 0 && entries[id].live && (i + 1 == text.size() || text[i + 1] == ' ')) {
+                best = id;
+                matchLength = i + 1 - pos;
+            }
+        }
+        return best;
+    }
+
+    // Sum of the weights of all entries occurring in `text`.
+    double boost(const std::string& text) const {
+        double total = 0.0;
+        for (size_t pos = 0; pos < text.size(); pos = nextWord(text, pos)) {
+            size_t length;
+            int id = matchAt(text, pos, length);
+            if (id >= 0) total += entries[id].weight;
+        }
+        return total;
+    }
+
+    // Copies `text` to `out` with every matched entry written in its
+    // replacement (or as listed, for casing). Non-overlapping, left to right.
+    void rewrite(const std::string& text, std::string& out) const {
+        out.clear();
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t length;
+            int id = matchAt(text, pos, length);
+            if (id >= 0 && !entries[id].replacement.empty()) {
+                out += entries[id].replacement;
+                pos += length;
+            } else {
+                size_t next = nextWord(text, pos);
+                out.append(text, pos, next - pos);
+                pos = next;
+                continue;
+            }
+            if (pos < text.size()) {
+                out += ' ';
+                pos++;
+            }
+        }
+        if (!out.empty() && out.back() == ' ') out.pop_back();
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Edge {
+        unsigned char label;
+        uint32_t child;
+    };
+
+    struct Node {
+        std::vector<Edge> edges;   // sorted by label
+        int32_t entry = -1;
+    };
+
+    const char* label;
+    std::vector<Node> nodes;
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, uint32_t> index;
+    size_t liveEntries = 0;
+    int64_t loadedStamp = 0;              // mtime in ns of the version loaded
+
+    void clear() {
+        nodes.assign(1, Node());
+        entries.clear();
+        index.clear();
+        liveEntries = 0;
+        loadedStamp = 0;
+    }
+
+    static size_t nextWord(const std::string& text, size_t pos) {
+        size_t space = text.find(' ', pos);
+        return space == std::string::npos ? text.size() : space + 1;
+    }
+
+    uint32_t child(uint32_t node, unsigned char label) const {
+        const std::vector<Edge>& edges = nodes[node].edges;
+        auto it = std::lower_bound(edges.begin(), edges.end(), label,
+                                   [](const Edge& e, unsigned char l) { return e.label < l; });
+        return (it != edges.end() && it->label == label) ? it->child : NONE;
+    }
+
+    void insert(const std::string& key, uint32_t id) {
+        uint32_t node = 0;
+        for (unsigned char c : key) {
+            uint32_t next = child(node, c);
+            if (next == NONE) {
+                next = static_cast<uint32_t>(nodes.size());
+                nodes.emplace_back();
+                std::vector<Edge>& edges = nodes[node].edges;
+                auto it = std::lower_bound(edges.begin(), edges.end(), c,
+                                           [](const Edge& e, unsigned char l) { return e.label < l; });
+                edges.insert(it, Edge{c, next});
+            }
+            node = next;
+        }
+        nodes[node].entry = static_cast<int32_t>(id);
+    }
+
+    static bool checkCoverage(const std::string& key, VoskModel* model) {
+        if (!model) return true;
+        size_t start = 0;
+        while (start < key.size()) {
+            size_t end = key.find(' ', start);
+            if (end == std::string::npos) end = key.size();
+            if (vosk_model_find_word(model, key.substr(start, end - start).c_str()) < 0) {
+                return false;
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+
+    // "phrase [weight]", "Cased Phrase [weight]" or "spoken form -> Written Form"
+    static bool parseLine(const std::string& line, double defaultWeight, Entry& entry) {
+        std::string text = line;
+        size_t comment = text.find('#');
+        if (comment != std::string::npos) text.erase(comment);
+
+        std::string written;
+        size_t arrow = text.find("->");
+        if (arrow != std::string::npos) {
+            written = normalizeSpaces(text.substr(arrow + 2));
+            text.erase(arrow);
+        }
+
+        std::vector<std::string> words;
+        size_t start = 0;
+        text = normalizeSpaces(text);
+        while (start < text.size()) {
+            size_t end = text.find(' ', start);
+            if (end == std::string::npos) end = text.size();
+            words.push_back(text.substr(start, end - start));
+            start = end + 1;
+        }
+        entry.weight = defaultWeight;
+        if (words.size() > 1) {
+            char* end;
+            double weight = std::strtod(words.back().c_str(), &end);
+            if (*end == '\0') {
+                entry.weight = weight;
+                words.pop_back();
+            }
+        }
+        if (words.empty()) return false;
+
+        std::string spoken;
+        for (const std::string& word : words) {
+            spoken += (spoken.empty() ? "" : " ") + word;
+        }
+        entry.key = spoken;
+        std::transform(entry.key.begin(), entry.key.end(), entry.key.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        // A listed phrase with capitals is also its own written form
+        entry.replacement = !written.empty() ? written : (spoken != entry.key ? spoken : "");
+        return true;
+    }
+
+    static std::string normalizeSpaces(const std::string& s) {
+        std::string out;
+        bool space = false;
+        for (char c : s) {
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                space = !out.empty();
+            } else {
+                if (space) out += ' ';
+                out += c;
+                space = false;
+            }
+        }
+        return out;
+    }
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Word error rate (substitutions + deletions + insertions over reference
+// words) for offline evaluation runs. Case-insensitive, whitespace-split.
+inline std::vector<std::string> splitWords(const std::string& text) {
+    std::vector<std::string> words;
+    std::istringstream stream(text);
+    std::string word;
+    while (stream >> word) {
+        std::transform(word.begin(), word.end(), word.begin(), [](unsigned char c) { return std::tolower(c); });
+        words.push_back(word);
+    }
+    return words;
+}
+
+inline double wordErrorRate(const std::string& hypothesis, const std::string& reference) {
+    std::vector<std::string> hyp = splitWords(hypothesis);
+    std::vector<std::string> ref = splitWords(reference);
+    if (ref.empty()) return hyp.empty() ? 0.0 : 1.0;
+
+    std::vector<size_t> previous(hyp.size() + 1);
+    std::vector<size_t> current(hyp.size() + 1);
+    for (size_t j = 0; j <= hyp.size(); j++) previous[j] = j;
+
+    for (size_t i = 1; i <= ref.size(); i++) {
+        current[0] = i;
+        for (size_t j = 1; j <= hyp.size(); j++) {
+            size_t substitution = previous[j - 1] + (ref[i - 1] == hyp[j - 1] ? 0 : 1);
+            current[j] = std::min({substitution, previous[j] + 1, current[j - 1] + 1});
+        }
+        std::swap(previous, current);
+    }
+    return static_cast<double>(previous[hyp.size()]) / ref.size();
+}
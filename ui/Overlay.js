@@ -3,6 +3,12 @@ import St from 'gi://St';
 import Clutter from 'gi://Clutter';
 import Pango from 'gi://Pango';
 import Gio from 'gi://Gio';
+import GLib from 'gi://GLib';
+
+// In front of the live transcript
+const TRANSCRIPT_PREFIX = '🔊 ';
+const TRANSCRIPT_PREFIX_CHARS = [...TRANSCRIPT_PREFIX].length;
+const TRANSCRIPT_PREFIX_BYTES = new TextEncoder().encode(TRANSCRIPT_PREFIX).length;
 
 /**
  * Overlay widget for displaying speech to text results
@@ -13,6 +19,7 @@ export class STTOverlay {
         this.overlay = null;
         this.overlayBox = null;
         this.overlayText = null;
+        this.shownTranscript = null;
         
         this._createOverlay();
         this._connectSettings();
@@ -250,11 +257,56 @@ export class STTOverlay {
                `word-wrap: break-word;`;
     }
 
+    /**
+     * Shows a status message (or anything else that is not the live
+     * transcript)
+     */
     updateText(text) {
         if (!this.overlayText) return;
         
-        const displayText = text || 'Konuşmaya hazır...\nBuraya tanınan metin görünecek.';
-        this.overlayText.text = displayText;
+        this.shownTranscript = null;
+        const clutterText = this.overlayText.clutter_text;
+        clutterText.use_markup = false;
+        clutterText.set_attributes(new Pango.AttrList());
+        this.overlayText.text = text || 'Konuşmaya hazır...\nBuraya tanınan metin görünecek.';
+    }
+
+    /**
+     * Shows the live transcript. The edits in `changes` are applied to the
+     * text already on screen, so an update costs the size of the edited
+     * segment rather than of the transcript; the whole text is only set
+     * when the overlay was showing something else. The tentative tail is
+     * dimmed with a Pango attribute instead of re-parsed markup.
+     * @param {Transcript} transcript
+     * @param {Array<{position: number, removed: number, inserted: string}>} changes
+     */
+    showTranscript(transcript, changes) {
+        if (!this.overlayText) return;
+        
+        const clutterText = this.overlayText.clutter_text;
+        if (this.shownTranscript !== transcript) {
+            clutterText.use_markup = false;
+            this.overlayText.text = TRANSCRIPT_PREFIX + transcript.displayText;
+            this.shownTranscript = transcript;
+        } else {
+            // Clutter counts characters; recognized text stays in the BMP,
+            // where they are the same as the transcript's UTF-16 offsets
+            for (const { position, removed, inserted } of changes) {
+                const at = TRANSCRIPT_PREFIX_CHARS + position;
+                if (removed > 0) clutterText.delete_text(at, at + removed);
+                if (inserted) clutterText.insert_text(inserted, at);
+            }
+        }
+        
+        const attributes = new Pango.AttrList();
+        const { start, end } = transcript.tentativeBytes();
+        if (start < end) {
+            const dimmed = Pango.attr_foreground_alpha_new(39321);   // 60%
+            dimmed.start_index = TRANSCRIPT_PREFIX_BYTES + start;
+            dimmed.end_index = TRANSCRIPT_PREFIX_BYTES + end;
+            attributes.insert(dimmed);
+        }
+        clutterText.set_attributes(attributes);
     }
 
     destroy() {
@@ -15,6 +15,7 @@ export class STTPanelButton {
         this.settings = settings;
         this.isRecording = false;
         this.recognizedText = '';
+        this.transcript = null;         // live transcript, when that is what is shown
         this.lastUpdateTime = 0;
         this.animationTimeout = null;
         
@@ -279,8 +280,22 @@ export class STTPanelButton {
         if (now - this.updateThrottle.text < 50) return;
         this.updateThrottle.text = now;
         
+        this.transcript = null;
         this.recognizedText = text;
-        
+        this._showText(text);
+    }
+
+    /**
+     * Shows the committed part of the live transcript. Only its first 100
+     * characters fit, so no more than those are read, and the label stops
+     * changing once they are committed.
+     */
+    showTranscript(transcript) {
+        this.transcript = transcript;
+        this._showText(transcript.stablePrefix(101));
+    }
+
+    _showText(text) {
         let displayText = text;
         if (displayText && displayText.length > 100) {
             displayText = displayText.substring(0, 97) + '...';
@@ -326,7 +341,7 @@ export class STTPanelButton {
     }
 
     getText() {
-        return this.recognizedText;
+        return this.transcript ? this.transcript.text : this.recognizedText;
     }
 
     // Performance monitoring
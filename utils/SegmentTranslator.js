@@ -0,0 +1,102 @@
+/**
+ * Translates finalized segments, not partial hypotheses. At most one
+ * request is in flight: the first segment goes out at once, and segments
+ * finalized while it is pending are sent together as the next batch.
+ * Segments seen recently, or queued twice, are translated once.
+ */
+export class SegmentTranslator {
+    /**
+     * @param {TranslationManager} translationManager
+     * @param {Function} onTranslated - (caption, result): the translation of
+     *   every segment so far, in segment order, and the newest result
+     * @param {number} maxBatch - most segments per request
+     */
+    constructor(translationManager, onTranslated, maxBatch = 8) {
+        this.translationManager = translationManager;
+        this.onTranslated = onTranslated;
+        this.maxBatch = maxBatch;
+        this.queue = [];
+        this.recent = new Map();
+        this.recentLimit = 256;
+        this.caption = '';
+        this.inFlight = false;
+        this.generation = 0;
+        this.stats = { segments: 0, requests: 0, deduped: 0 };
+    }
+
+    /**
+     * A segment the recognizer will not change again
+     */
+    add(id, text) {
+        text = text.trim();
+        if (text.length <= 3) return;
+
+        this.stats.segments++;
+        this.queue.push({ id, text });
+        this._flush();
+    }
+
+    /**
+     * Drops queued segments and the caption (a new recording)
+     */
+    clear() {
+        this.queue = [];
+        this.caption = '';
+        this.inFlight = false;
+        this.generation++;
+        this.stats = { segments: 0, requests: 0, deduped: 0 };
+    }
+
+    async _flush() {
+        if (this.inFlight || this.queue.length === 0) return;
+
+        const batch = this.queue.splice(0, this.maxBatch);
+        const generation = this.generation;
+        const texts = [];
+        for (const { text } of batch) {
+            if (this.recent.has(text) || texts.includes(text)) {
+                this.stats.deduped++;
+            } else {
+                texts.push(text);
+            }
+        }
+
+        this.inFlight = true;
+        let results = [];
+        try {
+            if (texts.length > 0) {
+                this.stats.requests++;
+                results = await this.translationManager.translateBatch(texts);
+            }
+        } catch (error) {
+            console.log(`Segment translation failed: ${error.message}`);
+        }
+        if (generation !== this.generation) return;
+        this.inFlight = false;
+
+        texts.forEach((text, index) => {
+            if (results[index] && !results[index].error) this._remember(text, results[index]);
+        });
+        let last = null;
+        for (const { text } of batch) {
+            let result = this.recent.get(text);
+            if (result) {
+                this._remember(text, result);
+            } else {
+                result = { original: text, translated: text, error: 'not translated' };
+            }
+            this.caption += (this.caption ? ' ' : '') + result.translated;
+            last = result;
+        }
+        this.onTranslated(this.caption, last);
+        this._flush();
+    }
+
+    _remember(text, result) {
+        this.recent.delete(text);
+        this.recent.set(text, result);
+        if (this.recent.size > this.recentLimit) {
+            this.recent.delete(this.recent.keys().next().value);
+        }
+    }
+}
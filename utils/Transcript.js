@@ -0,0 +1,152 @@
+/**
+ * Recognized text of one recording, kept as the backend's segments
+ * (utterances). Finished segments at the front are folded once into a
+ * committed prefix, so an edit only touches its own open segment, and
+ * apply() says where the displayed text changed for views to patch it in
+ * place instead of re-rendering the whole transcript.
+ *
+ * The displayed text is every non-empty segment followed by one space.
+ * Offsets are UTF-16 code units, as the backend's `keep` and `stable`.
+ */
+export class Transcript {
+    constructor() {
+        this.committed = '';        // folded final segments, as displayed
+        this.committedBytes = 0;    // UTF-8 length of `committed`
+        this.open = new Map();      // id -> {text, stable, final}, in segment order
+    }
+
+    /**
+     * Applies one edit: keep the first `keep` characters of segment `id`
+     * and append `tail`.
+     * @returns {{position: number, removed: number, inserted: string, text: string}}
+     *   the change to the displayed text, and the segment's text after it
+     */
+    apply(id, keep, tail, stable, final) {
+        let position = this.committed.length;
+        for (const [openId, other] of this.open) {
+            if (openId >= id) break;
+            position += displayLength(other.text);
+        }
+        let segment = this.open.get(id);
+        if (!segment) {
+            segment = { text: '', stable: 0, final: false };
+            this._insert(id, segment);
+        }
+        const before = segment.text;
+        keep = Math.min(keep, before.length);
+        segment.text = before.slice(0, keep) + tail;
+        segment.stable = Math.min(stable, segment.text.length);
+        segment.final = final;
+
+        // Finals arrive in order; fold the finished ones at the front
+        for (const [openId, other] of this.open) {
+            if (!other.final) break;
+            this._fold(other);
+            this.open.delete(openId);
+        }
+
+        if (before && segment.text) {
+            return { position: position + keep, removed: before.length - keep, inserted: tail, text: segment.text };
+        }
+        return {
+            position,
+            removed: displayLength(before),
+            inserted: segment.text ? `${segment.text} ` : '',
+            text: segment.text
+        };
+    }
+
+    /**
+     * Takes the open segments as final (the backend exited before
+     * finalizing them); the displayed text does not change.
+     * @returns {Array<{id: number, text: string}>}
+     */
+    finalizeOpen() {
+        const finalized = [];
+        for (const [id, segment] of this.open) {
+            if (segment.text) finalized.push({ id: Number(id), text: segment.text });
+            this._fold(segment);
+        }
+        this.open.clear();
+        return finalized;
+    }
+
+    /** Full text; O(length), for copying and display of translations */
+    get text() {
+        return this.displayText.trimEnd();
+    }
+
+    get displayText() {
+        let text = this.committed;
+        for (const segment of this.open.values()) {
+            if (segment.text) text += `${segment.text} `;
+        }
+        return text;
+    }
+
+    /** The first `limit` characters of the text that will not change */
+    stablePrefix(limit) {
+        let text = this.committed.slice(0, limit);
+        for (const segment of this.open.values()) {
+            if (text.length >= limit) break;
+            if (!segment.text) continue;
+            text += segment.text.slice(0, segment.stable);
+            if (segment.stable < segment.text.length) break;
+            text += ' ';
+        }
+        return text.slice(0, limit).trimEnd();
+    }
+
+    /**
+     * UTF-8 byte range of the displayed text that may still be revised
+     * (the recognizer's tentative tail); empty when everything is stable
+     */
+    tentativeBytes() {
+        let start = this.committedBytes;
+        let end = start;
+        let settled = true;
+        for (const segment of this.open.values()) {
+            if (!segment.text) continue;
+            const bytes = utf8Length(segment.text);
+            if (settled && segment.stable < segment.text.length) {
+                start = end + utf8Length(segment.text.slice(0, segment.stable));
+                settled = false;
+            }
+            end += bytes + 1;
+        }
+        return settled ? { start: end, end } : { start, end: end - 1 };
+    }
+
+    // A segment's first line can come after later segments' partials when
+    // it was finalized without any of its own
+    _insert(id, segment) {
+        const last = [...this.open.keys()].pop();
+        if (last === undefined || last < id) {
+            this.open.set(id, segment);
+            return;
+        }
+        this.open = new Map([...this.open, [id, segment]].sort((a, b) => a[0] - b[0]));
+    }
+
+    _fold(segment) {
+        if (!segment.text) return;
+        this.committed += `${segment.text} `;
+        this.committedBytes += utf8Length(segment.text) + 1;
+    }
+}
+
+function displayLength(text) {
+    return text ? text.length + 1 : 0;
+}
+
+function utf8Length(text) {
+    let bytes = 0;
+    for (let i = 0; i < text.length; i++) {
+        const code = text.charCodeAt(i);
+        if (code < 0x80) bytes += 1;
+        else if (code < 0x800) bytes += 2;
+        else if (code >= 0xD800 && code < 0xE000) bytes += 2;   // either half of a 4-byte pair
+        else bytes += 3;
+    }
+    return bytes;
+}
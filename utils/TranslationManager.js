@@ -32,7 +32,7 @@ export class TranslationManager {
         this.supportedServices = {
             'google': 'Google Translate',
             'libretranslate': 'LibreTranslate',
-            'offline': 'Offline (Future)'
+            'offline': 'Offline (local)'
         };
     }
 
@@ -50,29 +50,13 @@ export class TranslationManager {
         
         // Check cache first
         const cacheKey = `${service}-${source}-${target}-${text}`;
-        if (this.cache.has(cacheKey)) {
-            const cached = this.cache.get(cacheKey);
-            if (Date.now() - cached.timestamp < this.cacheTimeout) {
-                return cached.result;
-            }
-            this.cache.delete(cacheKey);
+        const cached = this._cached(cacheKey);
+        if (cached) {
+            return cached;
         }
         
-        let result;
         try {
-            switch (service) {
-                case 'google':
-                    result = await this._translateWithGoogle(text, source, target);
-                    break;
-                case 'libretranslate':
-                    result = await this._translateWithLibreTranslate(text, source, target);
-                    break;
-                case 'offline':
-                    result = await this._translateOffline(text, source, target);
-                    break;
-                default:
-                    throw new Error(`Unsupported translation service: ${service}`);
-            }
+            const result = await this._translateWith(service, text, source, target);
             
             // Cache the result
             this.cache.set(cacheKey, {
@@ -92,6 +76,70 @@ export class TranslationManager {
         }
     }
 
+    /**
+     * Translate several segments with one request where possible: the
+     * uncached ones are sent as one text, one segment per line, and the
+     * reply is split back into lines. When the service does not keep the
+     * line structure, they are translated one by one instead.
+     * @returns {Promise<Array<Object>>} one result per text, in order
+     */
+    async translateBatch(texts, sourceLanguage = null, targetLanguage = null) {
+        const service = this.settings.get_string('translation-service');
+        const source = sourceLanguage || this.settings.get_string('translation-source-language');
+        const target = targetLanguage || this.settings.get_string('translation-target-language');
+        
+        const results = texts.map(text => this._cached(`${service}-${source}-${target}-${text}`));
+        const missing = texts.map((text, index) => index).filter(index => !results[index]);
+        if (missing.length > 1) {
+            try {
+                const joined = missing.map(index => texts[index].replace(/\n/g, ' ')).join('\n');
+                const reply = await this._translateWith(service, joined, source, target);
+                const lines = reply.translated.split('\n');
+                if (lines.length === missing.length) {
+                    missing.forEach((index, line) => {
+                        results[index] = { ...reply, original: texts[index], translated: lines[line].trim() };
+                        this.cache.set(`${service}-${source}-${target}-${texts[index]}`, {
+                            result: results[index],
+                            timestamp: Date.now()
+                        });
+                    });
+                    return results;
+                }
+            } catch (error) {
+                console.log(`Batch translation error: ${error.message}`);
+            }
+        }
+        for (const index of missing) {
+            results[index] = await this.translateText(texts[index], source, target);
+        }
+        return results;
+    }
+
+    _cached(cacheKey) {
+        const cached = this.cache.get(cacheKey);
+        if (!cached) {
+            return null;
+        }
+        if (Date.now() - cached.timestamp < this.cacheTimeout) {
+            return cached.result;
+        }
+        this.cache.delete(cacheKey);
+        return null;
+    }
+
+    _translateWith(service, text, source, target) {
+        switch (service) {
+            case 'google':
+                return this._translateWithGoogle(text, source, target);
+            case 'libretranslate':
+                return this._translateWithLibreTranslate(text, source, target);
+            case 'offline':
+                return this._translateOffline(text, source, target);
+            default:
+                throw new Error(`Unsupported translation service: ${service}`);
+        }
+    }
+
     /**
      * Translate using Google Translate (free web API)
      */
@@ -137,9 +185,9 @@ export class TranslationManager {
                         const data = JSON.parse(responseText);
                         translatedText = data.data.translations[0].translatedText;
                     } else {
-                        // Parse free API response
+                        // Parse free API response: one entry per sentence
                         const data = JSON.parse(responseText);
-                        translatedText = data[0][0][0];
+                        translatedText = data[0].map(sentence => sentence[0]).join('');
                     }
                     
                     resolve({
@@ -200,11 +248,11 @@ export class TranslationManager {
     }
 
     /**
-     * Offline translation (placeholder for future implementation)
+     * Offline translation runs in the C++ backend on final segments while
+     * recording (see ses/translator.h); there is no on-demand path here.
      */
     async _translateOffline(text, source, target) {
-        // This would use local translation models in the future
-        throw new Error('Offline translation not yet implemented. Please use Google or LibreTranslate.');
+        throw new Error('Offline translation is applied by the recorder backend while recording.');
     }
 
     /**